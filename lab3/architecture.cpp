@@ -0,0 +1,199 @@
+#include "architecture.h"
+
+//settings of one resource as read, before they are checked and compiled into a resource row
+struct resource_description {
+    string label;
+    unsigned long line_number = 0;
+    string kind;
+    double ratio = 0.0;
+    unsigned int size = 0;
+    unsigned int max_width = 0;
+    vector<pair<unsigned int, unsigned int> > config_list;
+    bool has_tdp_max_width = false;
+    unsigned int tdp_max_width = 0;
+    bool has_area = false;
+    double area = 0.0;
+    unsigned int type = 0;
+};
+
+static bool arch_error(const string& file_name, unsigned long line_number, const string& message){
+    cout<<file_name<<":"<<line_number<<": "<<message<<endl;
+    return false;
+}
+
+static bool parse_positive(const string& token, unsigned int& value){
+    if(token.empty() || token.size() > 9 || token.find_first_not_of("0123456789") != string::npos){
+        return false;
+    }
+    value = atoi(token.c_str());
+    return value > 0;
+}
+
+static bool parse_area(const string& token, double& value){
+    char* end;
+    value = strtod(token.c_str(), &end);
+    return !token.empty() && *end == '\0' && value > 0 && std::isfinite(value);
+}
+
+static bool parse_config(const string& token, pair<unsigned int, unsigned int>& config){
+    size_t split = token.find('x');
+    return split != string::npos && parse_positive(token.substr(0, split), config.first) &&
+           parse_positive(token.substr(split + 1), config.second);
+}
+
+//check one described resource and turn it into the row construct_resource would have built for it
+static bool compile_resource(const string& file_name, const resource_description& description, size_t position,
+                             resource& compiled){
+    bool is_lutram = description.kind == "lutram";
+    if(description.kind.empty()){
+        return arch_error(file_name, description.line_number, "resource " + description.label + " has no kind");
+    }
+    if(description.ratio <= 0){
+        return arch_error(file_name, description.line_number, "resource " + description.label + " has no ratio");
+    }
+    if(is_lutram ? description.ratio < 1 : description.ratio != floor(description.ratio)){
+        return arch_error(file_name, description.line_number, "resource " + description.label + (is_lutram ?
+                          ": the LUTRAM ratio should be at least 1" : ": the BRAM ratio should be a whole number"));
+    }
+    vector<pair<unsigned int, unsigned int> > config_list = description.config_list;
+    unsigned int size = description.size;
+    unsigned int max_width = description.max_width;
+    unsigned int max_depth = 0;
+    if(config_list.empty()){
+        if(is_lutram || size == 0 || max_width == 0 || max_width > size){
+            return arch_error(file_name, description.line_number, "resource " + description.label + " needs " +
+                              (is_lutram ? "configs" : "configs, or a size and a max_width no larger than it"));
+        }
+        max_depth = size;
+    }else{
+        for(auto& config: config_list){
+            max_depth = max(max_depth, config.first);
+            max_width = max(max_width, config.second);
+            size = max(size, config.first * config.second);
+        }
+    }
+    resource row(is_lutram ? LUTRAM : BRAM_CUSTOM, description.ratio, max_depth, max_width, size, config_list);
+    if(config_list.empty()){
+        row.prepare_combination();
+    }
+    if(description.has_tdp_max_width){
+        row.set_tdp_max_width(description.tdp_max_width);
+    }
+    if(description.has_area){
+        row.set_block_area(description.area);
+    }else if(!is_lutram){
+        row.set_block_area(bram_block_area(size, max_width));
+    }
+    row.set_output_type(description.type == 0 ? position + 1 : description.type, description.label);
+    compiled = row;
+    return true;
+}
+
+bool load_architecture(const string& arch_file, vector<resource>& resource_list, area_model& model){
+    ifstream file(arch_file);
+    if(!file){
+        cout<<"Cannot open the architecture file: "<<arch_file<<endl;
+        return false;
+    }
+    double lb_area = LB_TILE_AREA;
+    double lutram_lb_area = LUTRAM_TILE_AREA;
+    vector<resource_description> description_list;
+    string line;
+    unsigned long line_number = 0;
+    while(getline(file, line)){
+        line_number++;
+        line = line.substr(0, line.find('#'));
+        stringstream line_stream(line);
+        string key;
+        if(!(line_stream>>key)){
+            continue;
+        }
+        if(key == "resource"){
+            resource_description description;
+            getline(line_stream>>ws, description.label);
+            while(!description.label.empty() && isspace((unsigned char)description.label.back())){
+                description.label.pop_back();
+            }
+            if(description.label.empty()){
+                return arch_error(arch_file, line_number, "a resource needs a label");
+            }
+            description.line_number = line_number;
+            description_list.push_back(description);
+            continue;
+        }
+        vector<string> value_list;
+        string value;
+        while(line_stream>>value){
+            value_list.push_back(value);
+        }
+        if(value_list.empty()){
+            return arch_error(arch_file, line_number, "missing value of " + key);
+        }
+        if(key == "lb_area" || key == "lutram_lb_area"){
+            if(value_list.size() != 1 || !parse_area(value_list[0], key == "lb_area" ? lb_area : lutram_lb_area)){
+                return arch_error(arch_file, line_number, key + " should be one positive number");
+            }
+            continue;
+        }
+        if(description_list.empty()){
+            return arch_error(arch_file, line_number, key + " is outside of any resource");
+        }
+        resource_description& description = description_list.back();
+        bool valid = value_list.size() == 1;
+        if(key == "kind"){
+            description.kind = value_list[0];
+            valid = valid && (description.kind == "lutram" || description.kind == "bram");
+        }else if(key == "ratio"){
+            valid = valid && parse_area(value_list[0], description.ratio);
+        }else if(key == "size"){
+            valid = valid && parse_positive(value_list[0], description.size);
+        }else if(key == "max_width"){
+            valid = valid && parse_positive(value_list[0], description.max_width);
+        }else if(key == "configs"){
+            description.config_list.resize(value_list.size());
+            valid = true;
+            for(size_t i = 0; i < value_list.size() && valid; i++){
+                valid = parse_config(value_list[i], description.config_list[i]);
+            }
+        }else if(key == "tdp_max_width"){
+            description.has_tdp_max_width = true;
+            valid = valid && (value_list[0] == "0" || parse_positive(value_list[0], description.tdp_max_width));
+        }else if(key == "area"){
+            description.has_area = true;
+            valid = valid && parse_area(value_list[0], description.area);
+        }else if(key == "type"){
+            valid = valid && parse_positive(value_list[0], description.type);
+        }else{
+            return arch_error(arch_file, line_number, "unknown setting " + key);
+        }
+        if(!valid){
+            return arch_error(arch_file, line_number, "invalid value of " + key);
+        }
+    }
+
+    if(description_list.empty()){
+        return arch_error(arch_file, line_number, "no resource is described");
+    }
+    resource_list.clear();
+    unsigned int lutram_count = 0;
+    for(size_t i = 0; i < description_list.size(); i++){
+        resource compiled(LUTRAM, 0, 0, 0, 0, vector<pair<unsigned int, unsigned int> >());
+        if(!compile_resource(arch_file, description_list[i], i, compiled)){
+            return false;
+        }
+        for(auto& other: resource_list){
+            if(other.get_output_type() == compiled.get_output_type()){
+                return arch_error(arch_file, description_list[i].line_number, "resource " + compiled.get_label() +
+                                  " has the same type number as " + other.get_label());
+            }
+        }
+        lutram_count += compiled.is_in_logic_block();
+        resource_list.push_back(compiled);
+    }
+    //the average tile area follows from the one LUTRAM-capable fraction of the logic blocks
+    if(lutram_count > 1){
+        return arch_error(arch_file, line_number, "at most one resource can be lutram");
+    }
+    model.build(resource_list, lb_area, lutram_lb_area);
+    return true;
+}
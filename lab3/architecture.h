@@ -0,0 +1,27 @@
+#ifndef LAB3_IMPLEMENTATION_ARCHITECTURE_H
+#define LAB3_IMPLEMENTATION_ARCHITECTURE_H
+
+#include "circuit.h"
+
+//./mapping 7 <architecture file>: a fabric described in a text file instead of one of the compiled in structures.
+//the file is read once and compiled into the same resource table and area_model that construct_resource builds,
+//so the mapper sees flat per-resource tables and nothing of the file is interpreted per candidate.
+//
+//one setting per line, "#" starts a comment:
+//    lb_area <area>              logic block tile area without LUTRAM (default 35000)
+//    lutram_lb_area <area>       logic block tile area with LUTRAM (default 40000)
+//    resource <label>            starts a resource; the label is the rest of the line and the resources keep
+//                                their file order. the lines below it up to the next resource describe it:
+//    kind lutram|bram
+//    ratio <number>              BRAM: logic blocks per block, LUTRAM: 1 in every <number> logic blocks has LUTRAM
+//    size <bits>                 with max_width, the configurations of a BRAM, halving the width down to 1
+//    max_width <bits>
+//    configs <depth>x<width> ... the configurations listed instead (required for LUTRAM)
+//    tdp_max_width <bits>        widest configuration TrueDualPort can use, 0 for none (default: BRAM half of
+//                                max_width, LUTRAM 0)
+//    area <area>                 area of one block (default: the BRAM area formula, LUTRAM has none)
+//    type <number>               type number written in the mapping file (default: the resource's position, from 1)
+//on a wrong line the file name, line number and reason are printed and false is returned
+bool load_architecture(const string& arch_file, vector<resource>& resource_list, area_model& model);
+
+#endif //LAB3_IMPLEMENTATION_ARCHITECTURE_H
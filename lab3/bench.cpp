@@ -0,0 +1,352 @@
+#include "circuit.h"
+#include "input_parser.h"
+#include "output_writer.h"
+#include "synthetic.h"
+#include "fixed_layout.h"
+#include <iomanip>
+#include <sys/stat.h>
+#include <errno.h>
+
+//wall-clock times of one phase over all repeats
+struct phase_timing {
+    string name;
+    vector<double> ms_list;
+    bool per_ram; //report a rams/s throughput for this phase
+};
+
+static double elapsed_ms(chrono::steady_clock::time_point start){
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+static bool parse_range(const string& spec, unsigned int& low, unsigned int& high){
+    size_t colon = spec.find(':');
+    if(colon == string::npos){
+        low = high = atoi(spec.c_str());
+    }else{
+        low = atoi(spec.substr(0, colon).c_str());
+        high = atoi(spec.substr(colon + 1).c_str());
+    }
+    return low > 0 && low <= high;
+}
+
+static bool parse_mix(const string& spec, double* weight){
+    stringstream spec_stream(spec);
+    string item;
+    int count = 0;
+    double total = 0;
+    while(getline(spec_stream, item, ',')){
+        if(count == 4){
+            return false;
+        }
+        weight[count] = atof(item.c_str());
+        if(weight[count] < 0){
+            return false;
+        }
+        total += weight[count++];
+    }
+    return count == 4 && total > 0;
+}
+
+static void print_usage(){
+    cout<<"usage: ./mapping_bench [-circuits N] [-rams min:max] [-mix sp,sdp,tdp,rom] [-depth min:max]"<<endl;
+    cout<<"       [-width min:max] [-lb min:max] [-seed S] [-arch 1|2|3|4] [-repeat R] [-t threads]"<<endl;
+    cout<<"       [-dir path] [-history file.csv] [-label text] [-generate-only] [-scalar]"<<endl;
+    cout<<"       [-check-scoring cases]"<<endl;
+    cout<<"Please refer to readme for details"<<endl;
+}
+
+//creates the directory and any missing parent, like mkdir -p; a directory that is already there is fine
+static bool make_directories(const string& path){
+    for(size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)){
+        string prefix = path.substr(0, slash);
+        if(!prefix.empty() && mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST){
+            return false;
+        }
+        if(slash == string::npos){
+            break;
+        }
+    }
+    struct stat path_stat;
+    return stat(path.c_str(), &path_stat) == 0 && S_ISDIR(path_stat.st_mode);
+}
+
+//the plain loop's choice against the scalar and AVX2 kernels of one layout
+template <typename layout>
+static bool layout_kernels_agree(const ram_scoring& ram, uint32_t scalar_best, uint32_t scalar_LB){
+    uint32_t layout_LB = 0, simd_LB = 0;
+    uint32_t layout_best = score_ram_layout<layout>(ram, layout_LB);
+    uint32_t simd_best = score_ram_simd<layout>(ram, simd_LB);
+    return layout_best == scalar_best && layout_LB == scalar_LB && simd_best == scalar_best && simd_LB == scalar_LB;
+}
+
+//scores random rams with the AVX2 kernel and the plain loop and compares the chosen candidates and their logic
+//blocks; counts up to 40 cover the masked tails, up to 10 resources the fallback past SIMD_SCORING_RESOURCES, half
+//the cases draw from small ranges so ties are common, and some start near 2^32 logic blocks so the sums wrap.
+//every other case is given the tables of a fixed layout and also checked with that layout's kernels
+static int check_scoring_kernels(unsigned int num_cases, unsigned int seed){
+    ram_scoring_kernel simd_kernel = avx2_scoring_kernel();
+    if(simd_kernel == NULL){
+        cout<<"No AVX2 on this CPU, only the plain scoring loop is used"<<endl;
+        return 0;
+    }
+    mt19937_64 generator(seed);
+    vector<uint32_t> blocks, extra_LB, resource, lutram_block, block_ratio, used_blocks;
+    for(unsigned int c = 0; c < num_cases; c++){
+        bool small = c % 2 == 0;
+        uint32_t count = uniform_int_distribution<uint32_t>(1, 40)(generator);
+        //0 any table, 1 Stratix-IV, 2 a single BRAM, 3 a BRAM followed by LUTRAM
+        unsigned int layout = c % 8 < 4 ? 0 : c % 4;
+        uint32_t num_resources = layout == 1 ? 3 : (layout == 2 ? 1 : (layout == 3 ? 2 : uniform_int_distribution<uint32_t>(1, 10)(generator)));
+        blocks.resize(count);
+        extra_LB.resize(count);
+        resource.resize(count);
+        lutram_block.resize(num_resources);
+        block_ratio.resize(num_resources);
+        used_blocks.resize(num_resources);
+        for(uint32_t i = 0; i < count; i++){
+            blocks[i] = uniform_int_distribution<uint32_t>(1, small ? 4 : 128)(generator);
+            extra_LB[i] = uniform_int_distribution<uint32_t>(0, small ? 2 : 60)(generator);
+            resource[i] = uniform_int_distribution<uint32_t>(0, num_resources - 1)(generator);
+        }
+        for(uint32_t r = 0; r < num_resources; r++){
+            lutram_block[r] = generator() % 3 == 0 ? 1 : 0;
+            block_ratio[r] = lutram_block[r] == 1 ? 0 : uniform_int_distribution<uint32_t>(1, small ? 3 : 400)(generator);
+            used_blocks[r] = uniform_int_distribution<uint32_t>(0, small ? 3 : 20000)(generator);
+            if(layout != 0){
+                lutram_block[r] = layout == 1 ? stratix_iv_layout::lutram_block(ram_scoring(), r) : (r == 1 ? 1 : 0);
+                block_ratio[r] = layout == 1 ? stratix_iv_layout::block_ratio(ram_scoring(), r) :
+                                 (r == 0 ? uniform_int_distribution<uint32_t>(1, small ? 3 : 400)(generator) : 0);
+            }
+        }
+        ram_scoring ram;
+        ram.blocks = blocks.data();
+        ram.extra_LB = extra_LB.data();
+        ram.resource = resource.data();
+        ram.count = count;
+        ram.logic_LB = c % 16 == 1 ? UINT32_MAX - (uint32_t)(generator() % 200) : (uint32_t)(generator() % (small ? 8 : 100000));
+        ram.lutram_block = lutram_block.data();
+        ram.block_ratio = block_ratio.data();
+        ram.used_blocks = used_blocks.data();
+        ram.num_resources = num_resources;
+        uint32_t scalar_LB = 0, simd_LB = 0;
+        uint32_t scalar_best = score_ram_scalar(ram, scalar_LB);
+        uint32_t simd_best = simd_kernel(ram, simd_LB);
+        bool agree = scalar_best == simd_best && scalar_LB == simd_LB;
+        if(layout == 1){
+            agree = agree && layout_kernels_agree<stratix_iv_layout>(ram, scalar_best, scalar_LB);
+        }else if(layout == 2){
+            agree = agree && layout_kernels_agree<single_bram_layout<false> >(ram, scalar_best, scalar_LB);
+        }else if(layout == 3){
+            agree = agree && layout_kernels_agree<single_bram_layout<true> >(ram, scalar_best, scalar_LB);
+        }
+        if(!agree){
+            cout<<"Scoring kernels disagree on case "<<c<<" ("<<count<<" candidates, "<<num_resources<<" resources, layout "
+                <<layout<<"): "
+                <<"scalar picks "<<scalar_best<<" with "<<scalar_LB<<" logic blocks, avx2 picks "<<simd_best<<" with "
+                <<simd_LB<<endl;
+            return 1;
+        }
+    }
+    cout<<"avx2 and scalar scoring agree on "<<num_cases<<" random rams"<<endl;
+    return 0;
+}
+
+int main(int argc, char **argv){
+    synthetic_spec spec;
+    int arch = 1;
+    unsigned int repeat = 5;
+    unsigned int num_threads = default_thread_count();
+    string data_dir = "./bench_data";
+    string history_file;
+    string label = "unlabeled";
+    bool generate_only = false;
+    unsigned int scoring_cases = 0;
+    for(int i = 1; i < argc; i++){
+        string flag = argv[i];
+        if(flag == "-generate-only"){
+            generate_only = true;
+            continue;
+        }
+        if(flag == "-scalar"){
+            set_scoring_kernel(false);
+            continue;
+        }
+        if(i + 1 >= argc){
+            print_usage();
+            return 1;
+        }
+        string value = argv[++i];
+        bool valid = true;
+        if(flag == "-circuits"){
+            spec.num_circuits = atoi(value.c_str());
+            valid = spec.num_circuits > 0;
+        }else if(flag == "-rams"){
+            valid = parse_range(value, spec.min_rams, spec.max_rams);
+        }else if(flag == "-mix"){
+            valid = parse_mix(value, spec.mode_weight);
+        }else if(flag == "-depth"){
+            valid = parse_range(value, spec.min_depth, spec.max_depth);
+        }else if(flag == "-width"){
+            valid = parse_range(value, spec.min_width, spec.max_width);
+        }else if(flag == "-lb"){
+            valid = parse_range(value, spec.min_lb, spec.max_lb);
+        }else if(flag == "-seed"){
+            spec.seed = atoi(value.c_str());
+        }else if(flag == "-arch"){
+            arch = atoi(value.c_str());
+            valid = arch >= 1 && arch <= 4;
+        }else if(flag == "-repeat"){
+            repeat = atoi(value.c_str());
+            valid = repeat > 0;
+        }else if(flag == "-t"){
+            num_threads = atoi(value.c_str());
+            valid = num_threads > 0;
+        }else if(flag == "-dir"){
+            data_dir = value;
+        }else if(flag == "-history"){
+            history_file = value;
+        }else if(flag == "-label"){
+            label = value;
+        }else if(flag == "-check-scoring"){
+            scoring_cases = atoi(value.c_str());
+            valid = scoring_cases > 0;
+        }else{
+            valid = false;
+        }
+        if(!valid){
+            cout<<"Cannot analyze the argument: "<<flag<<" "<<value<<endl;
+            print_usage();
+            return 1;
+        }
+    }
+
+    if(scoring_cases > 0){
+        return check_scoring_kernels(scoring_cases, spec.seed);
+    }
+
+    if(!make_directories(data_dir)){
+        cout<<"Cannot create the benchmark directory "<<data_dir<<endl;
+        return 1;
+    }
+    string rams_file = data_dir + "/logical_rams.txt";
+    string bc_file = data_dir + "/logic_block_count.txt";
+    string cache_file = data_dir + "/logical_rams.bin";
+    string mapping_file = data_dir + "/mapping.txt";
+
+    auto start = chrono::steady_clock::now();
+    long long total_rams = write_synthetic_benchmark(spec, rams_file, bc_file);
+    if(total_rams < 0){
+        cout<<"Cannot write the benchmark files in "<<data_dir<<endl;
+        return 1;
+    }
+    double generate_ms = elapsed_ms(start);
+    cout<<"Generated "<<spec.num_circuits<<" circuits with "<<total_rams<<" logical rams in "<<rams_file<<" ("
+        <<fixed<<setprecision(1)<<generate_ms<<" ms)"<<endl;
+    if(generate_only){
+        return 0;
+    }
+
+    //the architectures of ./mapping 1 to 4 with the example parameters of the readme
+    operationType op = STRATIX_IV;
+    vector<unsigned int> size_vec, mwidth_vec, bratio_vec;
+    double lutram_ratio = 0.0;
+    if(arch == 2 || arch == 3){
+        op = arch == 2 ? NO_LUTRAM : WITH_LUTRAM;
+        size_vec = {8192};
+        mwidth_vec = {32};
+        bratio_vec = {10};
+    }else if(arch == 4){
+        op = MB_WITH_LUTRAM;
+        lutram_ratio = 3;
+        size_vec = {8192, 131072};
+        mwidth_vec = {32, 128};
+        bratio_vec = {10, 300};
+    }
+    input_parameter input_pack(size_vec, mwidth_vec, bratio_vec, lutram_ratio);
+
+    vector<phase_timing> phase_list = {{"parse", {}, true}, {"cache_load", {}, true}, {"resources", {}, false},
+                                       {"mapping", {}, true}, {"output", {}, true}};
+    //the mapper prints one line per circuit, which is not part of what is measured
+    ofstream null_stream("/dev/null");
+    mapper_options options;
+    options.num_threads = num_threads;
+    //the mapped rows of every repeat go to the same arena, which is only allocated by the first one
+    mapping_arena arena;
+    for(unsigned int run = 0; run < repeat; run++){
+        benchmark_set benchmark;
+        start = chrono::steady_clock::now();
+        if(!parse_input(benchmark, rams_file, bc_file)){
+            return 1;
+        }
+        phase_list[0].ms_list.push_back(elapsed_ms(start));
+
+        if(run == 0 && !write_benchmark_cache(benchmark, cache_file, rams_file, bc_file)){
+            cout<<"Cannot write the benchmark cache "<<cache_file<<endl;
+            return 1;
+        }
+        benchmark_set cached_benchmark;
+        start = chrono::steady_clock::now();
+        if(!load_benchmark_cache(cached_benchmark, cache_file, rams_file, bc_file)){
+            cout<<"Cannot load the benchmark cache "<<cache_file<<endl;
+            return 1;
+        }
+        phase_list[1].ms_list.push_back(elapsed_ms(start));
+
+        start = chrono::steady_clock::now();
+        vector<resource> resource_list;
+        area_model model;
+        construct_resource(resource_list, model, op, input_pack);
+        phase_list[2].ms_list.push_back(elapsed_ms(start));
+
+        streambuf* console = cout.rdbuf(null_stream.rdbuf());
+        start = chrono::steady_clock::now();
+        perform_core_mapper(benchmark.get_circuit_list(), resource_list, model, options, arena);
+        phase_list[3].ms_list.push_back(elapsed_ms(start));
+        cout.rdbuf(console);
+
+        start = chrono::steady_clock::now();
+        if(!write_mapping_text(mapping_file, benchmark.get_circuit_list(), num_threads)){
+            cout<<"Cannot write the mapping file "<<mapping_file<<endl;
+            return 1;
+        }
+        phase_list[4].ms_list.push_back(elapsed_ms(start));
+    }
+
+    cout<<"architecture "<<arch<<", "<<num_threads<<" threads, "<<repeat<<" runs, "
+        <<scoring_kernel_name(get_scoring_kernel())<<" scoring"<<endl;
+    cout<<left<<setw(12)<<"phase"<<right<<setw(12)<<"min ms"<<setw(12)<<"median ms"<<setw(12)<<"max ms"
+        <<setw(16)<<"Mrams/s"<<endl;
+    vector<double> median_list;
+    for(auto& phase: phase_list){
+        sort(phase.ms_list.begin(), phase.ms_list.end());
+        double median = phase.ms_list[phase.ms_list.size() / 2];
+        median_list.push_back(median);
+        cout<<left<<setw(12)<<phase.name<<right<<setw(12)<<phase.ms_list.front()<<setw(12)<<median
+            <<setw(12)<<phase.ms_list.back();
+        if(phase.per_ram && median > 0){
+            cout<<setw(16)<<total_rams / median / 1000.0;
+        }
+        cout<<endl;
+    }
+
+    //one csv row per benchmark run with the median of every phase, so releases can be compared
+    if(!history_file.empty()){
+        bool new_file = !ifstream(history_file).good();
+        ofstream history(history_file, ios::app);
+        if(new_file){
+            history<<"label,timestamp,arch,threads,circuits,rams,seed,generate_ms";
+            for(auto& phase: phase_list){
+                history<<","<<phase.name<<"_ms";
+            }
+            history<<"\n";
+        }
+        history<<label<<","<<time(NULL)<<","<<arch<<","<<num_threads<<","<<spec.num_circuits<<","<<total_rams<<","
+               <<spec.seed<<","<<generate_ms;
+        for(auto median: median_list){
+            history<<","<<median;
+        }
+        history<<"\n";
+        cout<<"Medians appended to "<<history_file<<endl;
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "checkpoint.h"
+#include "input_parser.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+
+static const char AREA_CHECKPOINT_MAGIC[8] = {'L', 'A', 'B', '3', 'C', 'K', 'P', 'T'};
+
+//the checksum covers the magic, so records of another format or version never pass for checkpoint records
+static uint64_t checkpoint_check(uint64_t job_key, double area){
+    uint64_t hash = FNV1A_OFFSET;
+    fnv1a(hash, AREA_CHECKPOINT_MAGIC, sizeof(AREA_CHECKPOINT_MAGIC));
+    uint64_t version = AREA_STATE_VERSION;
+    fnv1a(hash, &version, sizeof(version));
+    fnv1a(hash, &job_key, sizeof(job_key));
+    fnv1a(hash, &area, sizeof(area));
+    return hash;
+}
+
+bool area_checkpoint::open_file(const string& checkpoint_file){
+    close_file();
+    fd = open(checkpoint_file.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    num_appended = 0;
+    return fd >= 0;
+}
+
+bool area_checkpoint::append(uint64_t job_key, double area){
+    area_checkpoint_record record;
+    record.job_key = job_key;
+    record.area = area;
+    record.check = checkpoint_check(job_key, area);
+    //O_APPEND moves to the end and writes in one step, so concurrent writers never interleave inside a record
+    if(write(fd, &record, sizeof(record)) != (ssize_t)sizeof(record)){
+        return false;
+    }
+    if((++num_appended) % AREA_CHECKPOINT_SYNC == 0){
+        fdatasync(fd);
+    }
+    return true;
+}
+
+bool area_checkpoint::close_file(){
+    if(fd < 0){
+        return true;
+    }
+    bool synced = fdatasync(fd) == 0;
+    bool closed = close(fd) == 0;
+    fd = -1;
+    return synced && closed;
+}
+
+size_t load_area_checkpoint(const string& checkpoint_file, unordered_map<uint64_t, double>& area_by_job,
+        size_t& damaged_bytes){
+    damaged_bytes = 0;
+    mapped_file checkpoint;
+    if(!checkpoint.open_file(checkpoint_file)){
+        return 0;
+    }
+    //records are read back to back; after a damaged one the reader moves on byte by byte until the records line up
+    //again, since other writers may have appended whole records after it
+    size_t num_records = 0;
+    size_t pos = 0;
+    size_t length = checkpoint.get_length();
+    while(pos + sizeof(area_checkpoint_record) <= length){
+        area_checkpoint_record record;
+        memcpy(&record, checkpoint.get_begin() + pos, sizeof(record));
+        if(record.check != checkpoint_check(record.job_key, record.area)){
+            damaged_bytes++;
+            pos++;
+            continue;
+        }
+        area_by_job[record.job_key] = record.area;
+        num_records++;
+        pos += sizeof(record);
+    }
+    damaged_bytes += length - pos;
+    return num_records;
+}
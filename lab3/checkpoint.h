@@ -0,0 +1,42 @@
+#ifndef LAB3_IMPLEMENTATION_CHECKPOINT_H
+#define LAB3_IMPLEMENTATION_CHECKPOINT_H
+
+#include "circuit.h"
+#include "fingerprint.h"
+
+//append-only checkpoint of a sweep: every checked (point, circuit) pair is one record of its job fingerprint, its
+//area and a checksum, added with a single write to a file opened for appending. threads and local processes can
+//share one checkpoint, and a killed run leaves every record it finished behind; records are synced to disk every
+//AREA_CHECKPOINT_SYNC appends and on close, so a power loss costs at most the last few, which are mapped again
+struct area_checkpoint_record {
+    uint64_t job_key;
+    double area;
+    uint64_t check;
+};
+
+const unsigned int AREA_CHECKPOINT_SYNC = 64;
+
+class area_checkpoint {
+private:
+    int fd;
+    atomic<unsigned int> num_appended;
+public:
+    area_checkpoint(){
+        fd = -1;
+        num_appended = 0;
+    }
+    ~area_checkpoint(){ close_file(); }
+    area_checkpoint(const area_checkpoint&) = delete;
+    area_checkpoint& operator=(const area_checkpoint&) = delete;
+    bool open_file(const string& checkpoint_file);
+    bool append(uint64_t job_key, double area);
+    bool close_file();
+};
+
+//adds every intact record of the checkpoint to area_by_job (a later record of the same job wins) and returns how
+//many there were; torn or damaged bytes, from a crash in the middle of a write, are skipped and counted in
+//damaged_bytes. a missing checkpoint has no records
+size_t load_area_checkpoint(const string& checkpoint_file, unordered_map<uint64_t, double>& area_by_job,
+        size_t& damaged_bytes);
+
+#endif //LAB3_IMPLEMENTATION_CHECKPOINT_H
@@ -1,22 +1,21 @@
 #include "circuit.h"
+#include "exact.h"
+#include "report.h"
+#include "score.h"
+#include "fixed_layout.h"
 
-string logicRam::get_lram_mode() {
-    string mode_result;
+const char* ram_mode_name(ramMode mode) {
     switch (mode){
         case SimpleDualPort:
-            mode_result = "SimpleDualPort";
-        break;
+            return "SimpleDualPort";
         case ROM:
-            mode_result = "ROM";
-        break;
+            return "ROM";
         case SinglePort:
-            mode_result = "SinglePort";
-        break;
+            return "SinglePort";
         case TrueDualPort:
-            mode_result = "TrueDualPort";
-        break;
+            return "TrueDualPort";
     }
-    return mode_result;
+    return "";
 }
 
 void resource::prepare_combination(){
@@ -28,28 +27,74 @@ void resource::prepare_combination(){
 }
 
 
-void construct_resource(vector<resource>& resource_list, operationType op, input_parameter input_pack) {
+double bram_block_area(unsigned int bits, unsigned int max_width){
+    return 9000 + 5 * bits + 90 * sqrt((double)bits) + 600 * 2 * max_width;
+}
+
+void area_model::build(const vector<resource>& resource_list, double lb_tile_area, double lutram_tile_area){
+    //the average tile area depends on which fraction of the logic blocks can be used as LUTRAM
+    lb_area = lb_tile_area;
+    block_ratio.clear();
+    lutram_block.clear();
+    lutram_share.clear();
+    bram_ratio.clear();
+    bram_area.clear();
+    for(auto& physical: resource_list){
+        if(physical.is_in_logic_block()){
+            double lutram_ratio = physical.get_ratio();
+            lb_area = lb_tile_area/lutram_ratio*(lutram_ratio-1) + lutram_tile_area/lutram_ratio;
+            block_ratio.push_back(0);
+            lutram_block.push_back(1);
+            lutram_share.push_back(lutram_ratio);
+        }else{
+            block_ratio.push_back((uint32_t)physical.get_ratio());
+            lutram_block.push_back(0);
+            lutram_share.push_back(0.0);
+            bram_ratio.push_back((uint32_t)physical.get_ratio());
+            bram_area.push_back(physical.get_block_area());
+        }
+    }
+    //the specialized mappers only fix the resource kinds and, for Stratix-IV, the ratios and tile area;
+    //block areas and whatever else a run passes in are still read from here
+    layout = GENERIC_LAYOUT;
+    if(block_ratio == vector<uint32_t>{0, 10, 300} && lb_area == STRATIX_IV_LB_AREA){
+        layout = STRATIX_IV_LAYOUT;
+    }else if(lutram_block == vector<uint32_t>{0} && block_ratio[0] > 0){
+        layout = SINGLE_BRAM_LAYOUT;
+    }else if(lutram_block == vector<uint32_t>{0, 1} && block_ratio[0] > 0){
+        layout = SINGLE_BRAM_LUTRAM_LAYOUT;
+    }
+}
+
+static resource make_lutram_resource(double lutram_ratio){
+    vector<pair<unsigned int, unsigned int> > comb;
+    resource lut_resource = resource(LUTRAM, lutram_ratio, 64, 20, 640, comb);
+    //directly insert, since only two combination available
+    pair<unsigned int, unsigned int> comb1(64, 10);
+    pair<unsigned int, unsigned int> comb2(32, 20);
+    lut_resource.add_dw_combination(comb1);
+    lut_resource.add_dw_combination(comb2);
+    lut_resource.set_output_type(1, "LUTRAM");
+    return lut_resource;
+}
+
+void construct_resource(vector<resource>& resource_list, area_model& model, operationType op,
+                        const input_parameter& input_pack) {
     if(op == STRATIX_IV){
         //insert LUTRAM resource
-        vector<pair<unsigned int, unsigned int> > comb;
-        resource lut_resource = resource(LUTRAM, 2.0, 64, 20, 640, comb);
-        //directly insert, since only two combination available
-        pair<unsigned int, unsigned int> comb1(64, 10);
-        pair<unsigned int, unsigned int> comb2(32, 20);
-        lut_resource.add_dw_combination(comb1);
-        lut_resource.add_dw_combination(comb2);
-        resource_list.push_back(lut_resource);
+        resource_list.push_back(make_lutram_resource(2.0));
 
         //insert 8192 BRAM
-        comb.empty();
+        vector<pair<unsigned int, unsigned int> > comb;
         resource bram8192_resource = resource(BRAM_8192, 10.0, 8192, 32, 8192, comb);
         bram8192_resource.prepare_combination();
+        bram8192_resource.set_output_type(2, "8192BRAM");
         resource_list.push_back(bram8192_resource);
 
         //insert 128k BRAM
-        comb.empty();
         resource bram128k_resource = resource(BRAM_128K, 300.0, 131072, 128, 131072, comb);
         bram128k_resource.prepare_combination();
+        bram128k_resource.set_output_type(3, "128k BRAM");
         resource_list.push_back(bram128k_resource);
     }else if(op == NO_LUTRAM || op == WITH_LUTRAM){
         //insert the only type of BRAM according to the input
@@ -59,380 +104,540 @@ void construct_resource(vector<resource>& resource_list, operationType op, input
         unsigned int m_width = input_pack.get_input_bram_mwidth()[0];
         resource bramcustom_resource = resource(BRAM_CUSTOM, ratio, bram, m_width, bram, comb);
         bramcustom_resource.prepare_combination();
+        //the checker numbers the lutram as type 1 whenever it is present
+        bramcustom_resource.set_output_type(op == NO_LUTRAM ? 1 : 2, "customed BRAM");
         resource_list.push_back(bramcustom_resource);
         if(op == WITH_LUTRAM){
             //insert LUTRAM resource
-            vector<pair<unsigned int, unsigned int> > comb;
-            resource lut_resource = resource(LUTRAM, 2.0, 64, 20, 640, comb);
-            //directly insert, since only two combination available
-            pair<unsigned int, unsigned int> comb1(64, 10);
-            pair<unsigned int, unsigned int> comb2(32, 20);
-            lut_resource.add_dw_combination(comb1);
-            lut_resource.add_dw_combination(comb2);
-            resource_list.push_back(lut_resource);
+            resource_list.push_back(make_lutram_resource(2.0));
         }
     }else if(op == MB_WITH_LUTRAM){
-        //insert LUTRAM resource
-        vector<pair<unsigned int, unsigned int> > comb;
-        resource lut_resource = resource(LUTRAM,input_pack.get_input_lutram_ratio(), 64, 20, 640, comb);
-        //directly insert, since only two combination available
-        pair<unsigned int, unsigned int> comb1(64, 10);
-        pair<unsigned int, unsigned int> comb2(32, 20);
-        lut_resource.add_dw_combination(comb1);
-        lut_resource.add_dw_combination(comb2);
-        resource_list.push_back(lut_resource);
+        //insert LUTRAM resource, followed by every BRAM passed in
+        resource_list.push_back(make_lutram_resource(input_pack.get_input_lutram_ratio()));
 
-        comb.empty();
-        resource bramcustom_resource = resource(BRAM_CUSTOM, input_pack.get_input_bram_ratio()[0],
-                input_pack.get_input_bram_size()[0],input_pack.get_input_bram_mwidth()[0],
-                input_pack.get_input_bram_size()[0], comb);
-        bramcustom_resource.prepare_combination();
-        resource_list.push_back(bramcustom_resource);
-
-        comb.empty();
-        resource bramcustom2_resource = resource(BRAM_CUSTOM_2, input_pack.get_input_bram_ratio()[1],
-                input_pack.get_input_bram_size()[1],input_pack.get_input_bram_mwidth()[1],
-                input_pack.get_input_bram_size()[1], comb);
-        bramcustom2_resource.prepare_combination();
-        resource_list.push_back(bramcustom2_resource);
+        for(size_t i = 0; i < input_pack.get_input_bram_size().size(); i++){
+            vector<pair<unsigned int, unsigned int> > comb;
+            resource bramcustom_resource = resource(i == 0 ? BRAM_CUSTOM : BRAM_CUSTOM_2,
+                    input_pack.get_input_bram_ratio()[i], input_pack.get_input_bram_size()[i],
+                    input_pack.get_input_bram_mwidth()[i], input_pack.get_input_bram_size()[i], comb);
+            bramcustom_resource.prepare_combination();
+            bramcustom_resource.set_output_type(i + 2, "customed BRAM" + (i == 0 ? string("") : to_string(i + 1)));
+            resource_list.push_back(bramcustom_resource);
+        }
     }
+    model.build(resource_list);
 }
 
-void perform_basic_core_mapper(vector<circuit>& logic_circuit_list, vector<resource>& resource_list){
-    for (auto& circuit: logic_circuit_list){
-        unsigned int existing_LB = circuit.get_circuit_num_lb();
-        unsigned int used_lutram = 0;
-        unsigned int used_8192bram = 0;
-        unsigned int used_128kbram = 0;
-        int id_count = 0;
-//        circuit.set_circuit_area(existing_LB * (35000+40000)/2); //MAGIC NUMBER HERE
-        double circuit_areatested = 0.0;
-//        cout<<"process circuit id: "<<circuit.get_circuit_id()<<endl;
-//        cout<<"it has: "<<circuit.get_ram_list().size()<<" number of logic rams"<<endl;
-
-        int logicram_count = 0;
-        for(auto& logicram: circuit.get_ram_list()){
-            //current cheapest mapped RAM for this current logic ram across all possible physical candidates
-            vector<mappedRam> cheapest_map_list;
-            double cheapest_area = DBL_MAX;
-
-            for(auto physical_candidate: resource_list){
-                if(physical_candidate.get_pram_type() == LUTRAM && logicram.get_lram_mode() == "TrueDualPort"){
-                    // lutram cannot support TDP
-                    continue;
-                }
-
-                //iterate through all possible dw combinations of current physical candidate
-                for(auto dw_pair: physical_candidate.get_comb_list()){
-                    unsigned int curr_depth = dw_pair.first;
-                    unsigned curr_width = dw_pair.second;
+unsigned int default_thread_count(){
+    unsigned int hw_threads = thread::hardware_concurrency();
+    return hw_threads == 0 ? 1 : hw_threads;
+}
 
-                    if(curr_width == physical_candidate.get_max_width() && logicram.get_lram_mode() == "TrueDualPort"){
-                        //widest width is not available for TDP
-                        continue;
-                    }
+void run_parallel_jobs(const vector<size_t>& job_order, unsigned int num_threads, const function<void(size_t)>& job){
+    //every worker pulls the next pending job from a shared cursor, so a thread that finishes a cheap job
+    //immediately steals the next one instead of idling behind a statically assigned slice
+    atomic<size_t> next_job(0);
+    auto worker = [&](){
+        for(size_t pos = next_job++; pos < job_order.size(); pos = next_job++){
+            job(job_order[pos]);
+        }
+    };
+    if(num_threads <= 1 || job_order.size() <= 1){
+        worker();
+        return;
+    }
+    unsigned int spawned = (unsigned int)min((size_t)num_threads, job_order.size());
+    vector<thread> workers;
+    for(unsigned int i = 1; i < spawned; i++){
+        workers.push_back(thread(worker));
+    }
+    worker();
+    for(auto& w: workers){
+        w.join();
+    }
+}
 
-                    int mapper_id = id_count ++;
-                    //decide how to locate logic using physical candidate
-                    unsigned int p = 1;
-                    unsigned int s = 1;
-                    unsigned int num_luts = 0;
-                    if(logicram.get_lram_width() > curr_width){
-                        p = (unsigned int)ceil((double)logicram.get_lram_width()/(double)curr_width);
-                    }
-                    if(logicram.get_lram_depth() > curr_depth){
-                        s = (unsigned int)ceil((double)logicram.get_lram_depth()/(double)curr_depth);
-                        if (s > 16){
-                            //dont consider any solution that is 16x deeper
-                            continue;
-                        }
-                        //compute extra logic needed(num_of_luts) when in serial
-                        if(s <= 4){
-                            if(s == 2){
-                                num_luts = 1*logicram.get_lram_width() + 1;
-                            }else{
-                                num_luts = 1*logicram.get_lram_width() + s;
-                            }
-                        }else if(s <= 7){
-                            num_luts = 2*logicram.get_lram_width() + s;
-                        }else if(s <= 10){
-                            num_luts = 3*logicram.get_lram_width() + s;
-                        }else if(s <= 13){
-                            num_luts = 4*logicram.get_lram_width() + s;
-                        }else{
-                            num_luts = 5*logicram.get_lram_width() + s;
-                        }
-                    }
-                    if(logicram.get_lram_mode() == "TrueDualPort") {// NOT SURE
-                        num_luts *= 2;
-                    }
-                    //test the area if use this pram, this combination
-                    unsigned int num_pram_plan = s * p;
-                    unsigned int extra_logic_LB = ceil((double)num_luts / 10.0);//MAGIC NUMBER HERE
-                    unsigned int LB_plan = 0; // total LB if use this pram
-                    unsigned int bram8192_plan = 0;
-                    unsigned int bram128k_plan = 0;
-                    if(physical_candidate.get_pram_type() == LUTRAM){
-                        LB_plan = existing_LB + used_lutram + num_pram_plan + extra_logic_LB;
-                    }else{
-                        LB_plan = existing_LB + used_lutram + extra_logic_LB;
-                        if(physical_candidate.get_pram_type() == BRAM_8192) {
-                            bram8192_plan = used_8192bram + num_pram_plan;
-                        }else {
-                            bram128k_plan = used_128kbram + num_pram_plan;
-                        }
-                    }
+//circuits are handed out largest first: the few circuits with thousands of RAMs start right away and
+//the many small ones fill in the gaps, which keeps all workers busy until the very end
+vector<size_t> largest_circuit_first(const vector<circuit>& logic_circuit_list){
+    vector<size_t> order(logic_circuit_list.size());
+    for(size_t i = 0; i < order.size(); i++){
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){
+        return logic_circuit_list[a].get_ram_list().size() > logic_circuit_list[b].get_ram_list().size();
+    });
+    return order;
+}
 
-                    unsigned int LBrequired_plan;
-                    if(LB_plan >= bram8192_plan * 10 && LB_plan >= bram128k_plan * 300){
-                        LBrequired_plan = LB_plan;
-                    }else if(bram8192_plan * 10 >= LB_plan && bram8192_plan * 10 >= bram128k_plan * 300){
-                        LBrequired_plan = bram8192_plan * 10;
-                    }else{
-                        LBrequired_plan = bram128k_plan * 300;
-                    }
-                    int required_8192 = floor((double)LBrequired_plan/(double)10);
-                    int required_128k = floor((double)LBrequired_plan/(double)300);
-                    double try_area = LBrequired_plan * 37500 + required_8192 * (9000 + 5 * 8192 + 90 * sqrt((double)8192) + 600 * 2 * 32)
-                            + required_128k * (9000 + 5 * 131072 + 90 * sqrt((double)131072) + 600 * 2 * 128);
-                    if(try_area < cheapest_area){
-                        if(try_area == 0){
-                            cout<<"Something went wrong, area should not be zero!!!"<<endl;
-                            exit(1);
-                        }
-                        cheapest_area = try_area;
-                        cheapest_map_list.insert(cheapest_map_list.begin(),
-                                mappedRam(logicram.get_lram_id(), mapper_id, num_luts, logicram.get_lram_depth(),
-                                        logicram.get_lram_width(), s, p, physical_candidate.get_pram_type(),
-                                        logicram.get_lram_mode(), curr_depth, curr_width, try_area));
-                    }
-                }// iterate through each combination of the same physical ram
-            }// iterate through all physical candidates, we have found the cheapset map for this logic ram
+void candidate_cache::add_shape(const vector<resource>& resource_list, const logicRam& logicram){
+    uint64_t key = shape_key(logicram);
+    if(shape_index.count(key)){
+        return;
+    }
+    bool is_tdp = logicram.get_lram_mode() == TrueDualPort;
+    uint32_t id_offset = 0;
+    uint32_t pruned_deep = 0;
+    uint32_t pruned_tdp = 0;
+    uint32_t pruned_dominated = 0;
+    for(size_t r = 0; r < resource_list.size(); r++){
+        const resource& physical_candidate = resource_list[r];
+        size_t resource_start = candidate_pool.size();
+        //iterate through all possible dw combinations of current physical candidate
+        for(auto& dw_pair: physical_candidate.get_comb_list()){
+            unsigned int curr_depth = dw_pair.first;
+            unsigned curr_width = dw_pair.second;
 
-            if(cheapest_map_list.empty()){
-                cout<<"No available mapped result found!!!"<<endl;
-                cout<<"Something went wrong"<<endl;
-                exit(1);
+            if(is_tdp && curr_width > physical_candidate.get_tdp_max_width()){
+                //this width (or the whole resource) is not available for TDP
+                pruned_tdp++;
+                continue;
             }
-            mappedRam cheapest_map = cheapest_map_list[0];
-            logic_circuit_list[circuit.get_circuit_id()].add_mapped_ram(cheapest_map);
 
-            existing_LB += ceil((double)(cheapest_map.get_lut()) / 10.0);//MAGIC NUMBER HERE
-            if(cheapest_map.get_map_type() == LUTRAM){
-                used_lutram += cheapest_map.get_s() * cheapest_map.get_p();
-            }else if(cheapest_map.get_map_type() == BRAM_8192){
-                used_8192bram += cheapest_map.get_s() * cheapest_map.get_p();
-            }else{
-                used_128kbram += cheapest_map.get_s() * cheapest_map.get_p();
+            uint32_t candidate_offset = id_offset ++;
+            //decide how to locate logic using physical candidate
+            unsigned int p = 1;
+            unsigned int s = 1;
+            if(logicram.get_lram_width() > curr_width){
+                p = (unsigned int)ceil((double)logicram.get_lram_width()/(double)curr_width);
             }
-            logicram_count++;
-            if(logicram_count == circuit.get_ram_list().size()){
-                circuit_areatested = cheapest_map.get_total_cost();
-                if(circuit_areatested == 0){
-                    cout<<"area got from mapped is zero!!!"<<endl;
-                    cout<<"Something went wrong"<<endl;
-                    exit(1);
+            if(logicram.get_lram_depth() > curr_depth){
+                s = (unsigned int)ceil((double)logicram.get_lram_depth()/(double)curr_depth);
+                if (s > 16){
+                    //dont consider any solution that is 16x deeper
+                    pruned_deep++;
+                    continue;
                 }
-                //print for debug purpose: this current circuit info
-                cout<<"circuit: "<<circuit.get_circuit_id()<<" used LUTRAM: "<<used_lutram
-                <<", used 8192BRAM: "<<used_8192bram
-                <<", used 128k BRAM: "<<used_128kbram
-                <<", my tested area is: "<<circuit_areatested<<endl;
             }
-        }// all logic ram in this circuit have been mapped
-        logic_circuit_list[circuit.get_circuit_id()].set_circuit_area(circuit_areatested);
+            unsigned int num_luts = serial_extra_luts(s, logicram.get_lram_width(), is_tdp);
+            map_candidate candidate;
+            candidate.resource_index = r;
+            candidate.id_offset = candidate_offset;
+            candidate.depth = curr_depth;
+            candidate.width = curr_width;
+            candidate.serial = s;
+            candidate.parallel = p;
+            candidate.num_luts = num_luts;
+            candidate.extra_LB = ceil((double)num_luts / 10.0);//MAGIC NUMBER HERE
+            candidate_pool.push_back(candidate);
+        }
+        //a candidate never wins when an earlier one of the same resource needs no more blocks and no more extra
+        //LUT blocks: the area only grows with both, and the earlier one wins ties. comparing with the kept ones
+        //is enough, whatever a dropped candidate dominates is dominated by the one that dropped it
+        size_t kept = resource_start;
+        for(size_t i = resource_start; i < candidate_pool.size(); i++){
+            const map_candidate& candidate = candidate_pool[i];
+            bool dominated = false;
+            for(size_t j = resource_start; j < kept && !dominated; j++){
+                dominated = candidate_pool[j].serial * candidate_pool[j].parallel <= candidate.serial * candidate.parallel &&
+                            candidate_pool[j].extra_LB <= candidate.extra_LB;
+            }
+            if(dominated){
+                pruned_dominated++;
+            }else{
+                candidate_pool[kept++] = candidate;
+            }
+        }
+        candidate_pool.resize(kept);
+        if(kept > resource_start){
+            resource_group group;
+            group.resource_index = r;
+            group.first = resource_start;
+            group.last = kept;
+            group.min_blocks = UINT32_MAX;
+            group.min_extra_LB = UINT32_MAX;
+            for(size_t i = resource_start; i < kept; i++){
+                group.min_blocks = min(group.min_blocks, candidate_pool[i].serial * candidate_pool[i].parallel);
+                group.min_extra_LB = min(group.min_extra_LB, candidate_pool[i].extra_LB);
+            }
+            group_pool.push_back(group);
+        }
     }
+    shape_index[key] = shape_id_span.size();
+    shape_id_span.push_back(id_offset);
+    shape_pruned_deep.push_back(pruned_deep);
+    shape_pruned_tdp.push_back(pruned_tdp);
+    shape_pruned_dominated.push_back(pruned_dominated);
+    shape_group_start.push_back(group_pool.size());
+    for(size_t i = shape_start.back(); i < candidate_pool.size(); i++){
+        candidate_blocks.push_back(candidate_pool[i].serial * candidate_pool[i].parallel);
+        candidate_extra_LB.push_back(candidate_pool[i].extra_LB);
+        candidate_resource.push_back(candidate_pool[i].resource_index);
+    }
+    shape_start.push_back(candidate_pool.size());
 }
 
-void perform_custom_core_mapper(vector<circuit>& logic_circuit_list, vector<resource>& resource_list, operationType op,
-                                vector<unsigned int>ratio_list){
-    for (auto& circuit: logic_circuit_list){
-        unsigned int existing_LB = circuit.get_circuit_num_lb();
-        unsigned int used_lutram = 0;
-        unsigned int used_cusbram = 0;
-        unsigned int used_cusbram2 = 0;
-        int id_count = 0;
-        double circuit_areatested = 0.0;
-
-        int logicram_count = 0;
+void candidate_cache::add_circuits(const vector<resource>& resource_list, const vector<circuit>& logic_circuit_list){
+    for(auto& circuit: logic_circuit_list){
         for(auto& logicram: circuit.get_ram_list()){
-            //current cheapest mapped RAM for this current logic ram across all possible physical candidates
-//            cout<<"processing circuit: "<<circuit.get_circuit_id()<<", logic ram id: "<<logicram_count<<endl;
-            vector<mappedRam> cheapest_map_list;
-            double cheapest_area = DBL_MAX;
+            add_shape(resource_list, logicram);
+        }
+    }
+}
+
+//two resource lists with the same key produce the same candidate lists, whatever their ratios and areas are
+string resource_geometry_key(const vector<resource>& resource_list){
+    ostringstream key;
+    for(auto& physical_candidate: resource_list){
+        key<<physical_candidate.is_in_logic_block()<<"/"<<physical_candidate.get_tdp_max_width();
+        for(auto& dw_pair: physical_candidate.get_comb_list()){
+            key<<"/"<<dw_pair.first<<"x"<<dw_pair.second;
+        }
+        key<<";";
+    }
+    return key.str();
+}
+
+vector<size_t> circuit_row_offsets(const vector<circuit>& logic_circuit_list){
+    vector<size_t> offset_list(logic_circuit_list.size() + 1, 0);
+    for(size_t i = 0; i < logic_circuit_list.size(); i++){
+        offset_list[i + 1] = offset_list[i] + logic_circuit_list[i].get_ram_list().size();
+    }
+    return offset_list;
+}
 
-            for(auto physical_candidate: resource_list){
-                if(physical_candidate.get_pram_type() == LUTRAM && logicram.get_lram_mode() == "TrueDualPort"){
-                    // lutram cannot support TDP
+template <typename layout>
+static void map_circuit_layout(const circuit& circuit, const vector<resource>& resource_list, const area_model& model,
+                               const candidate_cache& cache, mapping_result& result, const uint32_t* visit_order){
+    size_t num_resources = layout::num_resources == 0 ? resource_list.size() : layout::num_resources;
+    unsigned int existing_LB = circuit.get_circuit_num_lb();
+    unsigned int used_lutram = 0;
+    //per resource, lutram blocks included; on the stack for a fixed layout, otherwise kept per thread so
+    //mapping a circuit allocates nothing
+    static thread_local vector<unsigned int> used_block_list;
+    unsigned int fixed_blocks[layout::num_resources == 0 ? 1 : layout::num_resources];
+    unsigned int* used_blocks = fixed_blocks;
+    if(layout::num_resources == 0){
+        used_block_list.assign(num_resources, 0);
+        used_blocks = used_block_list.data();
+    }else{
+        fill(fixed_blocks, fixed_blocks + num_resources, 0);
+    }
+    //per resource constants of the scoring kernel, likewise
+    static thread_local vector<uint32_t> lutram_list, ratio_list;
+    uint32_t fixed_lutram[layout::num_resources == 0 ? 1 : layout::num_resources];
+    uint32_t fixed_ratio[layout::num_resources == 0 ? 1 : layout::num_resources];
+    uint32_t* lutram_table = fixed_lutram;
+    uint32_t* ratio_table = fixed_ratio;
+    if(layout::num_resources == 0){
+        lutram_list.resize(num_resources);
+        ratio_list.resize(num_resources);
+        lutram_table = lutram_list.data();
+        ratio_table = ratio_list.data();
+    }
+    for(size_t r = 0; r < num_resources; r++){
+        lutram_table[r] = model.get_lutram_block(r);
+        ratio_table[r] = model.get_block_ratio(r);
+    }
+    int id_count = 0;
+    double circuit_areatested = 0.0;
+    //the layout's own kernel, called directly so the scalar loop is inlined here
+    bool simd = simd_scoring_enabled();
+
+    const_span<logicRam> logic_ram_list = circuit.get_ram_list();
+    if(result.mapped_list.size() != logic_ram_list.size()){
+        cout<<"Circuit "<<circuit.get_circuit_id()<<" is mapped into "<<result.mapped_list.size()<<" rows for "
+            <<logic_ram_list.size()<<" logic rams"<<endl;
+        cout<<"Something went wrong"<<endl;
+        exit(1);
+    }
+    size_t logicram_count = 0;
+    for(size_t visit = 0; visit < logic_ram_list.size(); visit++){
+        const logicRam& logicram = logic_ram_list[visit_order == NULL ? visit : visit_order[visit]];
+        uint32_t shape = 0;
+        if(!cache.find_shape(logicram, shape)){
+            cout<<"Logic ram "<<logicram.get_lram_id()<<" of circuit "<<circuit.get_circuit_id()
+                <<" has no prepared candidates!!!"<<endl;
+            cout<<"Something went wrong"<<endl;
+            exit(1);
+        }
+        //test the area if use this pram, each combination: the logic, lutram and extra LUT blocks so far against
+        //the candidate's own block count, the other BRAM types are not part of the plan. the kernel scores the
+        //cached candidates of the shape and finds the first with the fewest logic blocks, the cheapest
+        ram_scoring scoring;
+        uint32_t first = cache.get_shape_start(shape);
+        scoring.blocks = cache.get_block_column() + first;
+        scoring.extra_LB = cache.get_extra_LB_column() + first;
+        scoring.resource = cache.get_resource_column() + first;
+        scoring.count = cache.get_shape_start(shape + 1) - first;
+        scoring.logic_LB = existing_LB + used_lutram;
+        scoring.lutram_block = lutram_table;
+        scoring.block_ratio = ratio_table;
+        scoring.used_blocks = used_blocks;
+        scoring.num_resources = num_resources;
+        if(scoring.count == 0){
+            cout<<"No available mapped result found!!!"<<endl;
+            cout<<"Something went wrong"<<endl;
+            exit(1);
+        }
+        uint32_t best_LB;
+        uint32_t best;
+        const resource_group* group_first = cache.group_begin(shape);
+        const resource_group* group_last = cache.group_end(shape);
+        if(group_last - group_first < 2){
+            best = simd ? score_ram_simd<layout>(scoring, best_LB) : score_ram_layout<layout>(scoring, best_LB);
+        }else{
+            //the first candidate of every resource is a real one, the cheapest of them is a bound the winner
+            //cannot exceed. a resource whose bound is above it has nothing the greedy could pick, so only the
+            //runs of the other resources go to the kernel, and the runs are merged in candidate order
+            uint32_t witness_LB = UINT32_MAX;
+            for(const resource_group* group = group_first; group != group_last; group++){
+                witness_LB = min(witness_LB, layout_candidate_LB<layout>(scoring, group->first - first));
+            }
+            best_LB = UINT32_MAX;
+            best = 0;
+            bool found = false;
+            ram_scoring run = scoring;
+            auto group_LB = [&](const resource_group* group){
+                return layout_resource_LB<layout>(scoring, group->resource_index, group->min_blocks, group->min_extra_LB);
+            };
+            for(const resource_group* group = group_first; group != group_last; ){
+                if(group_LB(group) > witness_LB){
+                    result.skipped_by_bound += group->last - group->first;
+                    group++;
                     continue;
                 }
+                uint32_t run_first = group->first - first;
+                uint32_t run_last = group->last - first;
+                for(group++; group != group_last && group_LB(group) <= witness_LB; group++){
+                    run_last = group->last - first;
+                }
+                run.blocks = scoring.blocks + run_first;
+                run.extra_LB = scoring.extra_LB + run_first;
+                run.resource = scoring.resource + run_first;
+                run.count = run_last - run_first;
+                uint32_t run_LB;
+                uint32_t run_best = simd ? score_ram_simd<layout>(run, run_LB) : score_ram_layout<layout>(run, run_LB);
+                if(!found || run_LB < best_LB){
+                    found = true;
+                    best_LB = run_LB;
+                    best = run_first + run_best;
+                }
+            }
+        }
+        double cheapest_area = layout::area_for_LB(model, best_LB);
+        if(cheapest_area == 0){
+            cout<<"Something went wrong, area should not be zero!!!"<<endl;
+            exit(1);
+        }
+        const map_candidate* cheapest_candidate = cache.get_candidate(first + best);
 
-                //iterate through all possible dw combinations of current physical candidate
-                for(auto dw_pair: physical_candidate.get_comb_list()){
-                    unsigned int curr_depth = dw_pair.first;
-                    unsigned curr_width = dw_pair.second;
+        mappedRam cheapest_map = mappedRam(logicram.get_lram_id(), id_count + cheapest_candidate->id_offset,
+                cheapest_candidate->num_luts, logicram.get_lram_depth(), logicram.get_lram_width(),
+                cheapest_candidate->serial, cheapest_candidate->parallel,
+                resource_list[cheapest_candidate->resource_index].get_output_type(), logicram.get_lram_mode(),
+                cheapest_candidate->depth, cheapest_candidate->width, cheapest_area);
+        result.mapped_list[visit] = cheapest_map;
+        result.choice_list[visit] = cheapest_candidate;
+        id_count += cache.get_id_span(shape);
 
-                    if(curr_width == physical_candidate.get_max_width() && logicram.get_lram_mode() == "TrueDualPort"){
-                        //widest width is not available for TDP
-                        continue;
-                    }
+        existing_LB += cheapest_candidate->extra_LB;
+        used_blocks[cheapest_candidate->resource_index] += cheapest_map.get_s() * cheapest_map.get_p();
+        if(resource_list[cheapest_candidate->resource_index].is_in_logic_block()){
+            used_lutram += cheapest_map.get_s() * cheapest_map.get_p();
+        }
+        logicram_count++;
+        if(logicram_count == logic_ram_list.size()){
+            circuit_areatested = cheapest_map.get_total_cost();
+            if(circuit_areatested == 0){
+                cout<<"area got from mapped is zero!!!"<<endl;
+                cout<<"Something went wrong"<<endl;
+                exit(1);
+            }
+            //print for debug purpose: this current circuit info
+            ostringstream circuit_log;
+            circuit_log<<"circuit: "<<circuit.get_circuit_id();
+            for(size_t b = 0; b < num_resources; b++){
+                circuit_log<<(b == 0 ? " used " : ", used ")<<resource_list[b].get_label()<<": "<<used_blocks[b];
+            }
+            circuit_log<<", my tested area is: "<<circuit_areatested<<endl;
+            result.summary = circuit_log.str();
+        }
+    }// all logic ram in this circuit have been mapped
+    //the area of the final mapping is priced like the checker prices it, on every path (greedy, portfolio, exact,
+    //refine), not with the greedy's running total printed above
+    result.area = mapping_area(circuit, model, result);
+}
 
-                    int mapper_id = id_count ++;
-                    //decide how to locate logic using physical candidate
-                    unsigned int p = 1;
-                    unsigned int s = 1;
-                    unsigned int num_luts = 0;
-                    if(logicram.get_lram_width() > curr_width){
-                        p = (unsigned int)ceil((double)logicram.get_lram_width()/(double)curr_width);
-                    }
-                    if(logicram.get_lram_depth() > curr_depth){
-                        s = (unsigned int)ceil((double)logicram.get_lram_depth()/(double)curr_depth);
-                        if (s > 16){
-                            //dont consider any solution that is 16x deeper
-                            continue;
-                        }
-                        //compute extra logic needed(num_of_luts) when in serial
-                        if(s <= 4){
-                            if(s == 2){
-                                num_luts = 1*logicram.get_lram_width() + 1;
-                            }else{
-                                num_luts = 1*logicram.get_lram_width() + s;
-                            }
-                        }else if(s <= 7){
-                            num_luts = 2*logicram.get_lram_width() + s;
-                        }else if(s <= 10){
-                            num_luts = 3*logicram.get_lram_width() + s;
-                        }else if(s <= 13){
-                            num_luts = 4*logicram.get_lram_width() + s;
-                        }else{
-                            num_luts = 5*logicram.get_lram_width() + s;
-                        }
-                    }
-                    if(logicram.get_lram_mode() == "TrueDualPort") {// NOT SURE
-                        num_luts *= 2;
-                    }
-                    //test the area if use this pram, this combination
-                    unsigned int num_pram_plan = s * p;
-                    unsigned int extra_logic_LB = ceil((double)num_luts / 10.0);//MAGIC NUMBER HERE
-                    unsigned int LB_plan = 0; // total LB if use this pram
-                    unsigned int bram_plan = 0;
-                    unsigned int bram1_plan = 0;
-                    unsigned int bram2_plan = 0;
-                    if(physical_candidate.get_pram_type() == LUTRAM){
-                        LB_plan = existing_LB + used_lutram + num_pram_plan + extra_logic_LB;
-                    }else{
-                        LB_plan = existing_LB + used_lutram + extra_logic_LB;
-                        if(op == MB_WITH_LUTRAM){
-                            if(physical_candidate.get_pram_type() == BRAM_CUSTOM){
-                                bram1_plan = used_cusbram + num_pram_plan;
-                            }else{
-                                bram2_plan = used_cusbram2 + num_pram_plan;
-                            }
-                        }else{
-                            bram_plan = used_cusbram + num_pram_plan;
-                        }
-                    }
+void map_circuit(const circuit& circuit, const vector<resource>& resource_list, const area_model& model,
+                 const candidate_cache& cache, mapping_result& result, const uint32_t* visit_order){
+    //the layout was recognized once when the model was built, the generic version covers every other table
+    switch(model.get_layout()){
+        case STRATIX_IV_LAYOUT:
+            map_circuit_layout<stratix_iv_layout>(circuit, resource_list, model, cache, result, visit_order);
+            break;
+        case SINGLE_BRAM_LAYOUT:
+            map_circuit_layout<single_bram_layout<false> >(circuit, resource_list, model, cache, result, visit_order);
+            break;
+        case SINGLE_BRAM_LUTRAM_LAYOUT:
+            map_circuit_layout<single_bram_layout<true> >(circuit, resource_list, model, cache, result, visit_order);
+            break;
+        default:
+            map_circuit_layout<generic_layout>(circuit, resource_list, model, cache, result, visit_order);
+    }
+}
 
-                    unsigned int LBrequired_plan;
-                    if(op == MB_WITH_LUTRAM){
-                        if(LB_plan >= bram1_plan * ratio_list[1] && LB_plan >= bram2_plan * ratio_list[2]){
-                            LBrequired_plan = LB_plan;
-                        }else if(bram1_plan * ratio_list[1] >= LB_plan && bram1_plan * ratio_list[1]
-                        >= bram2_plan * ratio_list[2]){
-                            LBrequired_plan = bram1_plan * ratio_list[1];
-                        }else{
-                            LBrequired_plan = bram2_plan * ratio_list[2];
-                        }
-                    }else{
-                        if(LB_plan >= bram_plan * physical_candidate.get_ratio()){
-                            LBrequired_plan = LB_plan;
-                        }else{
-                            LBrequired_plan = bram_plan * physical_candidate.get_ratio();
-                        }
-                    }
+//point every circuit at its mapped rows of the arena, in circuit order
+static void store_mapping_results(vector<circuit>& logic_circuit_list, vector<mapping_result>& result_list){
+    for(size_t i = 0; i < logic_circuit_list.size(); i++){
+        logic_circuit_list[i].set_mapped_list(result_list[i].mapped_list.begin(), result_list[i].mapped_list.size());
+        logic_circuit_list[i].set_circuit_area(result_list[i].area);
+        cout<<result_list[i].summary;
+    }
+}
 
-                    int required_bram = floor((double)LBrequired_plan/(double)physical_candidate.get_ratio());
-                    double try_area;
-                    unsigned int bram_bits = physical_candidate.get_pram_size();
-                    unsigned int bram_mwidth = physical_candidate.get_max_width();
-                    if(op == NO_LUTRAM){
-                        try_area = LBrequired_plan * 35000 + required_bram * (9000 +
-                                5 * bram_bits + 90 * sqrt((double)bram_bits) + 600 * 2 * bram_mwidth);
-                    }else if(op == WITH_LUTRAM){
-                        try_area = LBrequired_plan * 37500 + required_bram * (9000 +
-                                5 * bram_bits + 90 * sqrt((double)bram_bits) + 600 * 2 * bram_mwidth);
-                    }else{
-                        unsigned int bram1_bits = resource_list[1].get_pram_size();
-                        unsigned int bram1_mwidth = resource_list[1].get_max_width();
-                        unsigned int bram2_bits = resource_list[2].get_pram_size();
-                        unsigned int bram2_mwidth = resource_list[2].get_max_width();
+//visiting orders of the portfolio: the input order first, then a few sorted orders, then random shuffles
+static const char* const ordering_names[] = {"input order", "largest bits first", "TrueDualPort first",
+                                             "widest first", "deepest first"};
+static const size_t num_sorted_orderings = sizeof(ordering_names) / sizeof(ordering_names[0]);
 
-                        int required_bram1 = floor((double)LBrequired_plan/(double)ratio_list[1]);
-                        int required_bram2 = floor((double)LBrequired_plan/(double)ratio_list[2]);
+static string ordering_name(size_t ordering){
+    if(ordering < num_sorted_orderings){
+        return ordering_names[ordering];
+    }
+    return "random order " + to_string(ordering - num_sorted_orderings + 1);
+}
 
-                        try_area = LBrequired_plan * ((35000/(double)ratio_list[0]*(ratio_list[0]-1)) + (40000/(double)ratio_list[0])) +
-                                required_bram1 * (9000 + 5 * bram1_bits + 90 * sqrt((double)bram1_bits) + 600 * 2 * bram1_mwidth) +
-                                required_bram2 * (9000 + 5 * bram2_bits + 90 * sqrt((double)bram2_bits) + 600 * 2 * bram2_mwidth);
-                    }
-//                    cout<<"try area this round is: "<<try_area<<endl;
-//                    cout<<"cheapest area this round is: "<<cheapest_area<<endl;
-                    if(try_area < cheapest_area){
-                        if(try_area == 0){
-                            cout<<"Something went wrong, area should not be zero!!!"<<endl;
-                            exit(1);
-                        }
-                        cheapest_area = try_area;
-                        cheapest_map_list.insert(cheapest_map_list.begin(),
-                                                 mappedRam(logicram.get_lram_id(), mapper_id, num_luts, logicram.get_lram_depth(),
-                                                           logicram.get_lram_width(), s, p, physical_candidate.get_pram_type(),
-                                                           logicram.get_lram_mode(), curr_depth, curr_width, try_area));
-                    }
-                }// iterate through each combination of the same physical ram
-            }// iterate through all physical candidates, we have found the cheapset map for this logic ram
-            if(cheapest_map_list.empty()){
-                cout<<"No available mapped result found!!!"<<endl;
-                cout<<"Something went wrong"<<endl;
-                exit(1);
-            }
-            mappedRam cheapest_map = cheapest_map_list[0];
-            logic_circuit_list[circuit.get_circuit_id()].add_mapped_ram(cheapest_map);
+//writes one index per logic ram of the circuit to visit_order
+static void make_visit_order(const circuit& circuit, size_t ordering, uint32_t* visit_order){
+    const_span<logicRam> logic_ram_list = circuit.get_ram_list();
+    uint32_t* visit_end = visit_order + logic_ram_list.size();
+    for(size_t i = 0; i < logic_ram_list.size(); i++){
+        visit_order[i] = i;
+    }
+    //sorted orders are stable, so rams that tie keep their input order
+    function<uint64_t(const logicRam&)> sort_key;
+    if(ordering == 1){
+        sort_key = [](const logicRam& ram){ return (uint64_t)ram.get_lram_depth() * ram.get_lram_width(); };
+    }else if(ordering == 2){
+        sort_key = [](const logicRam& ram){ return (uint64_t)(ram.get_lram_mode() == TrueDualPort); };
+    }else if(ordering == 3){
+        sort_key = [](const logicRam& ram){ return (uint64_t)ram.get_lram_width(); };
+    }else if(ordering == 4){
+        sort_key = [](const logicRam& ram){ return (uint64_t)ram.get_lram_depth(); };
+    }
+    if(sort_key){
+        stable_sort(visit_order, visit_end, [&](uint32_t a, uint32_t b){
+            return sort_key(logic_ram_list[a]) > sort_key(logic_ram_list[b]);
+        });
+    }else if(ordering >= num_sorted_orderings){
+        mt19937 generator(circuit.get_circuit_id() * 7919 + ordering);
+        shuffle(visit_order, visit_end, generator);
+    }
+}
 
-            existing_LB += ceil((double)(cheapest_map.get_lut()) / 10.0);//MAGIC NUMBER HERE
-            if(cheapest_map.get_map_type() == LUTRAM){
-                used_lutram += cheapest_map.get_s() * cheapest_map.get_p();
-            }else if(cheapest_map.get_map_type() == BRAM_CUSTOM_2){
-                used_cusbram2 += cheapest_map.get_s() * cheapest_map.get_p();
-            }else{
-                used_cusbram += cheapest_map.get_s() * cheapest_map.get_p();
-            }
-            logicram_count++;
-            if(logicram_count == circuit.get_ram_list().size()){
-                circuit_areatested = cheapest_map.get_total_cost();
-                if(circuit_areatested == 0){
-                    cout<<"area got from mapped is zero!!!"<<endl;
-                    cout<<"Something went wrong"<<endl;
-                    exit(1);
-                }
-                //print for debug purpose: this current circuit info
-                cout<<"circuit: "<<circuit.get_circuit_id()<<" used LUTRAM: "<<used_lutram
-                    <<", used customed BRAM: "<<used_cusbram
-                    <<", used customed BRAM2: "<<used_cusbram2
-                    <<", my tested area is: "<<circuit_areatested<<endl;
-            }
-            if(op == NO_LUTRAM && used_lutram != 0){
-                cout<<"Lutram used is not zero in this operation mode, which is not expected!!!"<<endl;
-                cout<<"Something went wrong"<<endl;
-                exit(1);
-            }
-            if(op == NO_LUTRAM || op == WITH_LUTRAM){
-                if(used_cusbram2 != 0){
-                    cout<<"Two types of bram are used in this operation mode, which is not expected!!!"<<endl;
-                    cout<<"Something went wrong"<<endl;
-                    exit(1);
-                }
+//map every circuit with portfolio_size visiting orders, one (circuit, ordering) pair per job, and keep for each
+//circuit the ordering whose mapping has the smallest area; ties go to the earlier ordering, so the input order
+//is kept unless another one is strictly better. the winner is put back in input order for the mapping file
+static void map_portfolio(const vector<circuit>& logic_circuit_list, const vector<resource>& resource_list,
+                          const area_model& model, const candidate_cache& cache, vector<mapping_result>& result_list, const mapper_options& options){
+    size_t num_orderings = options.portfolio_size;
+    //ordering k of circuit c uses the rows of c in the k-th copy of the run's rows, for its trial and visiting order
+    vector<size_t> offset_list = circuit_row_offsets(logic_circuit_list);
+    size_t num_rows = offset_list.back();
+    mapping_arena trial_arena;
+    trial_arena.reserve_rows(num_rows * num_orderings);
+    vector<uint32_t> order_column(num_rows * num_orderings);
+    vector<vector<mapping_result> > trial_list(logic_circuit_list.size(), vector<mapping_result>(num_orderings));
+    for(size_t c = 0; c < logic_circuit_list.size(); c++){
+        for(size_t k = 0; k < num_orderings; k++){
+            trial_arena.bind(trial_list[c][k], k * num_rows + offset_list[c], offset_list[c + 1] - offset_list[c]);
+        }
+    }
+    vector<size_t> job_order;
+    for(size_t c: largest_circuit_first(logic_circuit_list)){
+        for(size_t k = 0; k < num_orderings; k++){
+            job_order.push_back(c * num_orderings + k);
+        }
+    }
+    run_parallel_jobs(job_order, options.num_threads, [&](size_t job){
+        size_t c = job / num_orderings;
+        size_t k = job % num_orderings;
+        uint32_t* visit_order = order_column.data() + k * num_rows + offset_list[c];
+        make_visit_order(logic_circuit_list[c], k, visit_order);
+        map_circuit(logic_circuit_list[c], resource_list, model, cache, trial_list[c][k], visit_order);
+    });
+    for(size_t c = 0; c < logic_circuit_list.size(); c++){
+        size_t best = 0;
+        double input_area = trial_list[c][0].area;
+        double best_area = input_area;
+        for(size_t k = 1; k < num_orderings; k++){
+            double trial_area = trial_list[c][k].area;
+            if(trial_area < best_area){
+                best_area = trial_area;
+                best = k;
             }
-        }// all logic ram in this circuit have been mapped
-        logic_circuit_list[circuit.get_circuit_id()].set_circuit_area(circuit_areatested);
+        }
+        mapping_result& winner = trial_list[c][best];
+        const uint32_t* visit_order = order_column.data() + best * num_rows + offset_list[c];
+        mapping_result& result = result_list[c];
+        for(size_t visit = 0; visit < winner.mapped_list.size(); visit++){
+            result.mapped_list[visit_order[visit]] = winner.mapped_list[visit];
+            result.choice_list[visit_order[visit]] = winner.choice_list[visit];
+        }
+        //the area the winner was chosen by, the same one the log line below gives
+        result.area = best_area;
+        for(size_t k = 0; k < num_orderings; k++){
+            result.skipped_by_bound += trial_list[c][k].skipped_by_bound;
+        }
+        ostringstream circuit_log;
+        circuit_log<<winner.summary<<"circuit: "<<logic_circuit_list[c].get_circuit_id()<<" best of "<<num_orderings
+                   <<" orderings is "<<ordering_name(best)<<" with area: "<<best_area<<" (input order: "<<input_area<<")"<<endl;
+        result.summary = circuit_log.str();
     }
 }
 
+void perform_core_mapper(vector<circuit>& logic_circuit_list, const vector<resource>& resource_list,
+                         const area_model& model, const mapper_options& options, mapping_arena& arena){
+    //each circuit has its own greedy state, so circuits are mapped independently and only the debug print
+    //is deferred to keep the console output in circuit order
+    auto stage_start = chrono::steady_clock::now();
+    phase_clock phases(options.report);
+    candidate_cache cache;
+    cache.add_circuits(resource_list, logic_circuit_list);
+    phases.mark("candidate_cache");
+    vector<mapping_result> result_list(logic_circuit_list.size());
+    vector<size_t> offset_list = circuit_row_offsets(logic_circuit_list);
+    arena.reserve_rows(offset_list.back());
+    for(size_t i = 0; i < logic_circuit_list.size(); i++){
+        arena.bind(result_list[i], offset_list[i], offset_list[i + 1] - offset_list[i]);
+    }
+    if(options.portfolio_size > 1){
+        map_portfolio(logic_circuit_list, resource_list, model, cache, result_list, options);
+        phases.mark("portfolio");
+    }else{
+        run_parallel_jobs(largest_circuit_first(logic_circuit_list), options.num_threads, [&](size_t i){
+            map_circuit(logic_circuit_list[i], resource_list, model, cache, result_list[i]);
+        });
+        phases.mark("greedy");
+    }
+    //priced like the report's final area, so the two can be compared
+    vector<double> greedy_area_list;
+    if(options.report != NULL){
+        for(size_t i = 0; i < logic_circuit_list.size(); i++){
+            greedy_area_list.push_back(result_list[i].area);
+        }
+    }
+    //small circuits can be searched exhaustively, the greedy results are the incumbents
+    if(options.exact_ram_limit > 0){
+        map_exact(logic_circuit_list, resource_list, model, cache, result_list, options);
+        phases.mark("exact");
+    }
+    //the greedy results are the seeds, whatever is left of the budget goes to improving them
+    if(options.refine_budget_ms > 0){
+        auto deadline = stage_start + chrono::microseconds((long long)(options.refine_budget_ms * 1000));
+        refine_circuits(logic_circuit_list, resource_list, model, cache, result_list, options.num_threads, deadline);
+        phases.mark("refine");
+    }
+    if(options.report != NULL){
+        point_report& point = options.report->last_point();
+        for(size_t i = 0; i < logic_circuit_list.size(); i++){
+            fill_circuit_report(logic_circuit_list[i], model, cache, result_list[i].choice_list, options.portfolio_size,
+                                result_list[i].skipped_by_bound, point.circuit_list[i]);
+            point.circuit_list[i].greedy_area = greedy_area_list[i];
+            point.circuit_list[i].proven_optimal = result_list[i].proven_optimal;
+        }
+    }
+    store_mapping_results(logic_circuit_list, result_list);
+    phases.mark("store_results");
+}
@@ -11,6 +11,15 @@
 #include <float.h>
 #include <ctime>
 #include <cmath>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
 
 using namespace std;
 
@@ -21,6 +30,8 @@ enum ramMode {
     TrueDualPort
 };
 
+const char* ram_mode_name(ramMode mode);
+
 enum arch_type{
     LUTRAM = 1,
     BRAM_8192,
@@ -50,58 +61,62 @@ public:
         bram_ratio = i_bratio;
         lutram_ratio = i_lratio;
     }
-    vector<unsigned int> get_input_bram_size(){return bram_size;}
-    vector<unsigned int> get_input_bram_mwidth(){return bram_mwidth;}
-    vector<unsigned int> get_input_bram_ratio(){return bram_ratio;}
-    double get_input_lutram_ratio(){return lutram_ratio;}
+    const vector<unsigned int>& get_input_bram_size() const {return bram_size;}
+    const vector<unsigned int>& get_input_bram_mwidth() const {return bram_mwidth;}
+    const vector<unsigned int>& get_input_bram_ratio() const {return bram_ratio;}
+    double get_input_lutram_ratio() const {return lutram_ratio;}
 };
 
+//one mapped RAM record, kept as a fixed-size trivially copyable record so mapped lists are plain contiguous
+//arrays without any per-record heap allocation; the mode is stored as ramMode and only turned into text on output
 class mappedRam {
 private:
-    int ram_id;
-    int mappedram_id;
-    unsigned int additional_lut;
-    unsigned int logic_depth;
-    unsigned int logic_width;
-    unsigned int serial;
-    unsigned int parallel;
-    arch_type type;
-    string lram_mode;
-    unsigned int mapped_depth;
-    unsigned int mapped_width;
     double cost;
+    uint32_t ram_id;
+    uint32_t mappedram_id;
+    uint32_t additional_lut;
+    uint32_t logic_depth;
+    uint32_t logic_width;
+    uint32_t parallel;
+    uint32_t mapped_depth;
+    uint32_t mapped_width;
+    uint8_t serial; //never more than 16, deeper solutions are rejected by the mapper
+    uint8_t type; //type number written to the mapping file, see resource::get_output_type
+    uint8_t lram_mode;
 public:
-    mappedRam(int i_ram_id, int i_mapper_id, unsigned int i_addlut, unsigned int i_ld, unsigned int i_lw,
-            unsigned int i_s, unsigned int i_p, arch_type i_type, string i_lram_mode, unsigned int i_mapd,
-            unsigned int i_mapw, double i_area){
+    mappedRam() = default;
+    mappedRam(unsigned int i_ram_id, unsigned int i_mapper_id, unsigned int i_addlut, unsigned int i_ld,
+            unsigned int i_lw, unsigned int i_s, unsigned int i_p, unsigned int i_type, ramMode i_lram_mode,
+            unsigned int i_mapd, unsigned int i_mapw, double i_area){
         ram_id = i_ram_id;
         mappedram_id = i_mapper_id;
         additional_lut = i_addlut;
         logic_depth = i_ld;
         logic_width = i_lw;
-        serial = i_s;
+        serial = (uint8_t)i_s;
         parallel = i_p;
-        type = i_type;
-        lram_mode = i_lram_mode;
+        type = (uint8_t)i_type;
+        lram_mode = (uint8_t)i_lram_mode;
         mapped_depth = i_mapd;
         mapped_width = i_mapw;
         cost = i_area;
     }
-    void change_type(arch_type format_type){type = format_type;}
-    int get_ram_id(){return ram_id;}
-    int get_mapper_id(){return mappedram_id;}
-    unsigned int get_lut(){return additional_lut;}
-    unsigned int get_ldepth(){return logic_depth;}
-    unsigned int get_lwidth(){return logic_width;}
-    unsigned int get_s(){return serial;}
-    unsigned int get_p(){return parallel;}
-    arch_type get_map_type(){return type;}
-    string get_lram_mode(){return lram_mode;}
-    unsigned int get_pdepth(){return mapped_depth;}
-    unsigned int get_pwidth(){return mapped_width;}
-    double get_total_cost(){return cost;}
+    unsigned int get_ram_id() const {return ram_id;}
+    unsigned int get_mapper_id() const {return mappedram_id;}
+    unsigned int get_lut() const {return additional_lut;}
+    unsigned int get_ldepth() const {return logic_depth;}
+    unsigned int get_lwidth() const {return logic_width;}
+    unsigned int get_s() const {return serial;}
+    unsigned int get_p() const {return parallel;}
+    unsigned int get_map_type() const {return type;}
+    ramMode get_lram_mode() const {return (ramMode)lram_mode;}
+    unsigned int get_pdepth() const {return mapped_depth;}
+    unsigned int get_pwidth() const {return mapped_width;}
+    double get_total_cost() const {return cost;}
 };
 
+static_assert(is_trivially_copyable<mappedRam>::value, "mappedRam should stay a plain record");
+
 class logicRam {
 private:
     unsigned int ram_id;
@@ -109,57 +124,115 @@ private:
     unsigned int depth;
     unsigned int width;
 public:
+    logicRam() = default;
     logicRam(unsigned int i_id, ramMode i_mode, unsigned int i_depth, unsigned int i_width){
         ram_id = i_id;
         mode = i_mode;
         depth = i_depth;
         width = i_width;
     }
-    unsigned int get_lram_id() { return ram_id; }
-    unsigned int get_lram_depth() { return depth; }
-    unsigned int get_lram_width() { return width; }
-    string get_lram_mode();
+    unsigned int get_lram_id() const { return ram_id; }
+    unsigned int get_lram_depth() const { return depth; }
+    unsigned int get_lram_width() const { return width; }
+    ramMode get_lram_mode() const { return mode; }
+};
+
+static_assert(is_trivially_copyable<logicRam>::value, "logicRam is stored as raw bytes in the benchmark cache");
+
+//read-only view of a contiguous range of records owned by someone else
+template <typename T>
+class const_span {
+private:
+    const T* first;
+    size_t length;
+public:
+    const_span(){
+        first = NULL;
+        length = 0;
+    }
+    const_span(const T* i_first, size_t i_length){
+        first = i_first;
+        length = i_length;
+    }
+    const T* begin() const { return first; }
+    const T* end() const { return first + length; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    const T& operator[](size_t i) const { return first[i]; }
 };
 
+//writable view of a contiguous range of records owned by someone else, e.g. one circuit's rows of a mapping_arena
+template <typename T>
+class span {
+private:
+    T* first;
+    size_t length;
+public:
+    span(){
+        first = NULL;
+        length = 0;
+    }
+    span(T* i_first, size_t i_length){
+        first = i_first;
+        length = i_length;
+    }
+    T* begin() const { return first; }
+    T* end() const { return first + length; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    T& operator[](size_t i) const { return first[i]; }
+    operator const_span<T>() const { return const_span<T>(first, length); }
+};
 
+//a circuit only refers to its logical RAMs, which live in one contiguous array owned by the benchmark_set
+//(parsed from text or mapped from the binary cache) so the same RAM data can be shared read-only; its mapped
+//RAMs likewise live in the mapping_arena of the run that mapped it
 class circuit {
 private:
     unsigned int circuit_id;
     unsigned int num_lb;
-    vector<logicRam> logic_ram_list;
-    vector<mappedRam> mapped_ram_list;
+    const_span<logicRam> logic_ram_list;
+    const_span<mappedRam> mapped_ram_list;
     double tested_area;
 public:
-    circuit(unsigned int i_id, unsigned int i_num, vector<logicRam> i_list, vector<mappedRam> i_mapped_list){
+    circuit(unsigned int i_id, unsigned int i_num){
         circuit_id = i_id;
         num_lb = i_num;
-        logic_ram_list = i_list;
-        mapped_ram_list = i_mapped_list;
+        tested_area = 0.0;
     }
-    void add_logic_ram(logicRam i_ram){
-        logic_ram_list.push_back(i_ram);
+    void set_ram_list(const logicRam* i_first, size_t i_count){
+        logic_ram_list = const_span<logicRam>(i_first, i_count);
     }
-    void add_mapped_ram(mappedRam i_mapped){
-        mapped_ram_list.push_back(i_mapped);
+    void set_mapped_list(const mappedRam* i_first, size_t i_count){
+        mapped_ram_list = const_span<mappedRam>(i_first, i_count);
     }
     void set_circuit_area(double i_area) {tested_area = i_area;}
-    unsigned int get_circuit_id() { return circuit_id; }
-    unsigned int get_circuit_num_lb() { return num_lb; }
-    vector<logicRam> get_ram_list(){ return logic_ram_list;}
-    vector<mappedRam> get_mapped_list(){ return mapped_ram_list;}
-    double get_circuit_area(){return tested_area;}
+    unsigned int get_circuit_id() const { return circuit_id; }
+    unsigned int get_circuit_num_lb() const { return num_lb; }
+    //read-only views, iterate them in place instead of copying the lists
+    const_span<logicRam> get_ram_list() const { return logic_ram_list;}
+    const_span<mappedRam> get_mapped_list() const { return mapped_ram_list;}
+    double get_circuit_area() const {return tested_area;}
 };
 
 extern vector<circuit> logic_circuit_list;
 
+double bram_block_area(unsigned int bits, unsigned int max_width);
+
+//one row of the resource table: every physical RAM type carries its own geometry, LB ratio, TDP restriction,
+//block area and the type number the checker expects in the mapping file
 class resource{
 private:
     arch_type physical_ram;
-    double ratio_to_block;
+    double ratio_to_block; //BRAM: logic blocks per BRAM block, LUTRAM: inverse of the LUTRAM-capable LB fraction
     unsigned int max_depth;
     unsigned int max_width;
     unsigned int size;
     vector<pair<unsigned int, unsigned int> > possible_comb;
+    unsigned int tdp_max_width; //widest configuration usable in TrueDualPort mode, 0 if TDP is not supported
+    double block_area; //area of one standalone block, LUTRAM lives inside logic blocks and has none
+    unsigned int output_type;
+    string label;
 public:
     resource(arch_type i_pram, double i_ratio, unsigned int i_mdepth, unsigned int i_mwidth,
             unsigned int i_size, vector<pair<unsigned int, unsigned int> > i_comb_list){
@@ -169,28 +242,257 @@ public:
         max_width = i_mwidth;
         size = i_size;
         possible_comb = i_comb_list;
+        //by default lutram cannot run TDP, and a BRAM loses its widest configuration in TDP
+        tdp_max_width = i_pram == LUTRAM ? 0 : i_mwidth / 2;
+        block_area = i_pram == LUTRAM ? 0.0 : bram_block_area(i_size, i_mwidth);
+        output_type = (unsigned int)i_pram;
+        label = "";
     }
 
     void add_dw_combination(pair<unsigned int, unsigned int> i_comb){
         possible_comb.push_back(i_comb);
     }
     void prepare_combination();
-    arch_type get_pram_type() { return physical_ram; }
-    double get_ratio() { return ratio_to_block; }
-    unsigned int get_max_depth() { return max_depth; }
-    unsigned int get_max_width() { return max_width; }
-    unsigned int get_pram_size() { return size; }
-    vector<pair<unsigned int, unsigned int> > get_comb_list(){ return possible_comb;}
+    void set_tdp_max_width(unsigned int i_width) { tdp_max_width = i_width; }
+    void set_block_area(double i_area) { block_area = i_area; }
+    void set_output_type(unsigned int i_type, string i_label) { output_type = i_type; label = i_label; }
+    arch_type get_pram_type() const { return physical_ram; }
+    bool is_in_logic_block() const { return physical_ram == LUTRAM; }
+    double get_ratio() const { return ratio_to_block; }
+    unsigned int get_max_depth() const { return max_depth; }
+    unsigned int get_max_width() const { return max_width; }
+    unsigned int get_pram_size() const { return size; }
+    const vector<pair<unsigned int, unsigned int> >& get_comb_list() const { return possible_comb;}
+    unsigned int get_tdp_max_width() const { return tdp_max_width; }
+    double get_block_area() const { return block_area; }
+    unsigned int get_output_type() const { return output_type; }
+    const string& get_label() const { return label; }
 };
 
 extern vector<resource> arch_resource_list;
 
-void construct_resource(vector<resource>& resource_list, operationType op, input_parameter input_pack);
+//one legal way of building a logical RAM shape out of one depth/width configuration of a resource; everything
+//in here only depends on the shape (TDP or not, depth, width) and on the resource geometry
+struct map_candidate {
+    uint32_t resource_index;
+    uint32_t id_offset; //position among the configurations tried for the shape, the mapper id is derived from it
+    uint32_t depth;
+    uint32_t width;
+    uint32_t serial;
+    uint32_t parallel;
+    uint32_t num_luts;
+    uint32_t extra_LB;
+};
+
+//the ladder of LUTs per data bit of the output mux that puts serial blocks together: one up to 4 blocks, one
+//more for every 3 after that, 5 from 14 blocks on (more than 16 are never mapped)
+constexpr unsigned int serial_mux_luts(unsigned int serial){
+    return serial == 1 ? 0 : (serial <= 4 ? 1 : (serial <= 7 ? 2 : (serial <= 10 ? 3 : (serial <= 13 ? 4 : 5))));
+}
+
+//LUTs of the decoder and output mux that put serial blocks together for a logical RAM of the given width,
+//doubled for the two ports of TrueDualPort; a single block in series needs none
+constexpr unsigned int serial_extra_luts(unsigned int serial, unsigned int width, bool is_tdp){
+    return serial == 1 ? 0 : (serial_mux_luts(serial) * width + (serial == 2 ? 1 : serial)) * (is_tdp ? 2 : 1);
+}
+static_assert(serial_extra_luts(2, 8, false) == 9 && serial_extra_luts(5, 8, false) == 21 &&
+              serial_extra_luts(16, 8, true) == 112, "serial_extra_luts is off the ladder");
+
+//the candidates of one shape on one resource, with the fewest blocks and extra LUT blocks among them; no candidate
+//of the group can need fewer logic blocks than a made-up candidate with both, which lets the greedy skip the group
+struct resource_group {
+    uint32_t resource_index;
+    uint32_t first; //candidates candidate_pool[first .. last)
+    uint32_t last;
+    uint32_t min_blocks;
+    uint32_t min_extra_LB;
+};
+
+//precomputed candidate lists keyed by logical RAM shape, built once before mapping and then shared read-only
+//by every circuit (and every sweep point with the same BRAM geometry)
+class candidate_cache {
+private:
+    vector<map_candidate> candidate_pool;
+    vector<uint32_t> candidate_blocks; //serial * parallel of candidate_pool[i], as a column for the scoring kernel
+    vector<uint32_t> candidate_extra_LB; //extra_LB of candidate_pool[i], likewise
+    vector<uint32_t> candidate_resource; //resource_index of candidate_pool[i], likewise
+    vector<uint32_t> shape_start; //candidates of shape i are candidate_pool[shape_start[i] .. shape_start[i+1])
+    vector<uint32_t> shape_id_span; //configurations tried for shape i, including the ones deeper than 16x
+    vector<uint32_t> shape_pruned_deep; //configurations of shape i dropped for needing more than 16 in series
+    vector<uint32_t> shape_pruned_tdp; //configurations of shape i too wide (or on a resource without) for TDP
+    vector<uint32_t> shape_pruned_dominated; //candidates of shape i dropped because an earlier one is never worse
+    vector<resource_group> group_pool;
+    vector<uint32_t> shape_group_start; //groups of shape i are group_pool[shape_group_start[i] .. [i+1])
+    unordered_map<uint64_t, uint32_t> shape_index;
+    static uint64_t shape_key(const logicRam& logicram){
+        return ((uint64_t)logicram.get_lram_depth() << 32) | ((uint64_t)logicram.get_lram_width() << 1) |
+               (logicram.get_lram_mode() == TrueDualPort ? 1 : 0);
+    }
+public:
+    candidate_cache(){
+        shape_start.push_back(0);
+        shape_group_start.push_back(0);
+    }
+    void add_shape(const vector<resource>& resource_list, const logicRam& logicram);
+    void add_circuits(const vector<resource>& resource_list, const vector<circuit>& logic_circuit_list);
+    bool find_shape(const logicRam& logicram, uint32_t& shape) const {
+        auto found = shape_index.find(shape_key(logicram));
+        if(found == shape_index.end()){
+            return false;
+        }
+        shape = found->second;
+        return true;
+    }
+    const map_candidate* shape_begin(uint32_t shape) const { return candidate_pool.data() + shape_start[shape]; }
+    const map_candidate* shape_end(uint32_t shape) const { return candidate_pool.data() + shape_start[shape + 1]; }
+    uint32_t get_id_span(uint32_t shape) const { return shape_id_span[shape]; }
+    uint32_t get_pruned_deep(uint32_t shape) const { return shape_pruned_deep[shape]; }
+    uint32_t get_pruned_tdp(uint32_t shape) const { return shape_pruned_tdp[shape]; }
+    uint32_t get_pruned_dominated(uint32_t shape) const { return shape_pruned_dominated[shape]; }
+    const resource_group* group_begin(uint32_t shape) const { return group_pool.data() + shape_group_start[shape]; }
+    const resource_group* group_end(uint32_t shape) const { return group_pool.data() + shape_group_start[shape + 1]; }
+    const map_candidate* get_candidate(uint32_t index) const { return candidate_pool.data() + index; }
+    const uint32_t* get_block_column() const { return candidate_blocks.data(); }
+    const uint32_t* get_extra_LB_column() const { return candidate_extra_LB.data(); }
+    const uint32_t* get_resource_column() const { return candidate_resource.data(); }
+    uint32_t get_shape_start(uint32_t shape) const { return shape_start[shape]; }
+    size_t get_shape_count() const { return shape_id_span.size(); }
+};
+
+string resource_geometry_key(const vector<resource>& resource_list);
+
+//a logic block tile is 35000 without lutram support and 40000 with it
+const double LB_TILE_AREA = 35000;
+const double LUTRAM_TILE_AREA = 40000;
+//average tile area when 1 in every 2 logic blocks has LUTRAM, as in Stratix-IV
+const double STRATIX_IV_LB_AREA = LB_TILE_AREA / 2 + LUTRAM_TILE_AREA / 2;
+
+//resource layouts the greedy mapper has a compile-time specialized version for (see fixed_layout.h); any other
+//table goes through the generic version
+enum layout_kind {
+    GENERIC_LAYOUT,
+    STRATIX_IV_LAYOUT, //LUTRAM (1 in 2), 8192 bit BRAM with ratio 10, 128k BRAM with ratio 300
+    SINGLE_BRAM_LAYOUT, //one BRAM, no LUTRAM
+    SINGLE_BRAM_LUTRAM_LAYOUT //one BRAM followed by LUTRAM
+};
+
+//area constants of one architecture, derived once from its resource table by construct_resource: the average
+//logic block tile area and, per resource row, its integer LB ratio or lutram share. pricing a candidate is then
+//a few integer operations plus one multiply-add per BRAM type, without branches on the resource kind
+class area_model {
+private:
+    double lb_area;
+    vector<uint32_t> block_ratio; //per resource: logic blocks per block for a BRAM, 0 for lutram
+    vector<uint32_t> lutram_block; //per resource: 1 for lutram, whose blocks are logic blocks, 0 for a BRAM
+    vector<double> lutram_share; //per resource: only 1 in every <share> logic blocks can be lutram, 0 for a BRAM
+    vector<uint32_t> bram_ratio; //BRAM rows only, in table order
+    vector<double> bram_area;
+    layout_kind layout;
+public:
+    area_model(){
+        lb_area = LB_TILE_AREA;
+        layout = GENERIC_LAYOUT;
+    }
+    void build(const vector<resource>& resource_list, double lb_tile_area = LB_TILE_AREA,
+               double lutram_tile_area = LUTRAM_TILE_AREA);
+    double get_lb_area() const { return lb_area; }
+    size_t get_resource_count() const { return block_ratio.size(); }
+    uint32_t get_block_ratio(size_t r) const { return block_ratio[r]; }
+    uint32_t get_lutram_block(size_t r) const { return lutram_block[r]; }
+    double get_lutram_share(size_t r) const { return lutram_share[r]; }
+    double get_bram_area(size_t b) const { return bram_area[b]; }
+    layout_kind get_layout() const { return layout; }
+    //area of an instance with LBrequired logic blocks and, of every BRAM type, as many blocks as its ratio gives.
+    //the product is taken in double: the original structure 2 and 3 mappers multiplied in 32 bits, which wrapped
+    //past 122713 (35000) or 114532 (37500) logic blocks and made such a candidate look cheap
+    double area_for_LB(unsigned int LBrequired) const {
+        double area = LBrequired * lb_area;
+        for(size_t b = 0; b < bram_ratio.size(); b++){
+            area += (int)(LBrequired / bram_ratio[b]) * bram_area[b];
+        }
+        return area;
+    }
+    //logic blocks needed when a circuit holding logic_LB logic blocks (its logic, extra LUTs and lutram so far)
+    //and used_blocks blocks of resource r adds num_blocks blocks of r plus extra_LB blocks of LUTs; only r's own
+    //blocks are weighed against the logic blocks, as the greedy mapper has always done
+    unsigned int LB_if_added(unsigned int logic_LB, size_t r, unsigned int used_blocks, unsigned int num_blocks,
+                             unsigned int extra_LB) const {
+        unsigned int LBrequired = logic_LB + extra_LB + lutram_block[r] * num_blocks;
+        unsigned int bram_LB = (used_blocks + num_blocks) * block_ratio[r];
+        return LBrequired > bram_LB ? LBrequired : bram_LB;
+    }
+    double area_if_added(unsigned int logic_LB, size_t r, unsigned int used_blocks, unsigned int num_blocks,
+                         unsigned int extra_LB) const {
+        return area_for_LB(LB_if_added(logic_LB, r, used_blocks, num_blocks, extra_LB));
+    }
+};
+
+//outcome of mapping one circuit, kept apart from the circuit so the same circuit can be mapped
+//against several architectures at once. the lists are rows of a mapping_arena, bound before mapping
+struct mapping_result {
+    span<mappedRam> mapped_list;
+    span<const map_candidate*> choice_list; //cached candidate behind every entry of mapped_list
+    double area = 0.0; //of the final mapping, priced with mapping_area like the checker prices it
+    bool proven_optimal = false; //set by the exact search, nothing smaller exists under the checker's area model
+    uint64_t skipped_by_bound = 0; //candidates the greedy did not score because their group's bound was too high
+    string summary;
+};
+
+//the mapped RAMs and chosen candidates of a whole run in two flat columns, sized once from the ram counts of the
+//parsed circuits and reused by later runs, so mapping allocates nothing per ram or per circuit. circuit i's rows
+//start at the sum of the ram counts of the circuits before it
+class mapping_arena {
+private:
+    vector<mappedRam> mapped_column;
+    vector<const map_candidate*> choice_column;
+public:
+    //make room for rows rows; the columns only ever grow, views handed out earlier are no longer valid
+    void reserve_rows(size_t rows){
+        if(mapped_column.size() < rows){
+            mapped_column.resize(rows);
+            choice_column.resize(rows);
+        }
+    }
+    void bind(mapping_result& result, size_t first_row, size_t num_rows){
+        result.mapped_list = span<mappedRam>(mapped_column.data() + first_row, num_rows);
+        result.choice_list = span<const map_candidate*>(choice_column.data() + first_row, num_rows);
+    }
+    const mappedRam* get_mapped_row(size_t row) const { return mapped_column.data() + row; }
+    mappedRam* get_mapped_row(size_t row) { return mapped_column.data() + row; }
+};
+
+//first arena row of every circuit, with the total number of rams as the last entry
+vector<size_t> circuit_row_offsets(const vector<circuit>& logic_circuit_list);
+
+class run_report;
+
+//settings of one perform_core_mapper run beyond the architecture itself
+struct mapper_options {
+    unsigned int num_threads = 1;
+    double refine_budget_ms = 0.0; //wall-clock budget of the whole mapping stage, 0 keeps the plain greedy result
+    unsigned int portfolio_size = 1; //ram orderings tried per circuit, 1 only maps them in input order
+    unsigned int exact_ram_limit = 0; //circuits with at most this many rams get the exact search, 0 turns it off
+    double exact_time_ms = 1000.0; //time limit of the exact search of one circuit
+    run_report* report = NULL; //phase times and per circuit figures are added to its last point, if any
+};
+
+void construct_resource(vector<resource>& resource_list, area_model& model, operationType op,
+        const input_parameter& input_pack);
+
+unsigned int default_thread_count();
+
+void run_parallel_jobs(const vector<size_t>& job_order, unsigned int num_threads, const function<void(size_t)>& job);
+
+vector<size_t> largest_circuit_first(const vector<circuit>& logic_circuit_list);
 
-void perform_basic_core_mapper(vector<circuit>& logic_circuit_list, vector<resource>& resource_list);
+//visit_order lists ram indices in the order the greedy should map them, NULL maps them in input order;
+//mapped_list and choice_list must be bound to one row per ram and always follow the visiting order
+void map_circuit(const circuit& circuit, const vector<resource>& resource_list, const area_model& model,
+        const candidate_cache& cache, mapping_result& result, const uint32_t* visit_order = NULL);
 
-void perform_custom_core_mapper(vector<circuit>& logic_circuit_list, vector<resource>& resource_list, operationType op,
-        vector<unsigned int>ratio_list);
+//the mapped RAMs of every circuit are left in arena, which must outlive the circuits' mapped lists
+void perform_core_mapper(vector<circuit>& logic_circuit_list, const vector<resource>& resource_list,
+        const area_model& model, const mapper_options& options, mapping_arena& arena);
 
 
 #endif //LAB3_IMPLEMENTATION_CIRCUIT_H
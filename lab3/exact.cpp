@@ -0,0 +1,159 @@
+#include "exact.h"
+
+//search state of one circuit; rams are visited biggest first so the expensive decisions are taken near the root
+class exact_search {
+private:
+    vector<size_t> ram_at_level;
+    vector<vector<const map_candidate*> > level_candidates; //per level, without candidates that cannot win
+    vector<unsigned int> open_extra_LB; //per level, fewest extra LUT blocks of the rams from that level on
+    mapping_counters counters;
+    vector<const map_candidate*> current_list; //per ram, in input order
+    chrono::steady_clock::time_point deadline;
+    size_t visited_nodes;
+    bool timed_out;
+    void search(size_t level);
+public:
+    vector<const map_candidate*> best_list;
+    double best_area;
+    exact_search(const circuit& circuit, const area_model& model, const candidate_cache& cache,
+                 const mapping_result& seed, chrono::steady_clock::time_point i_deadline);
+    //false when the deadline cut the search short
+    bool run(){
+        search(0);
+        return !timed_out;
+    }
+};
+
+exact_search::exact_search(const circuit& circuit, const area_model& model, const candidate_cache& cache,
+                           const mapping_result& seed, chrono::steady_clock::time_point i_deadline)
+        : counters(model, circuit.get_circuit_num_lb()){
+    const_span<logicRam> logic_ram_list = circuit.get_ram_list();
+    size_t num_rams = logic_ram_list.size();
+    deadline = i_deadline;
+    visited_nodes = 0;
+    timed_out = false;
+    current_list.assign(num_rams, NULL);
+    best_list.assign(seed.choice_list.begin(), seed.choice_list.end());
+    mapping_counters seed_counters(model, circuit.get_circuit_num_lb());
+    for(auto chosen: seed.choice_list){
+        seed_counters.add(*chosen);
+    }
+    best_area = seed_counters.area();
+
+    ram_at_level.resize(num_rams);
+    for(size_t i = 0; i < num_rams; i++){
+        ram_at_level[i] = i;
+    }
+    stable_sort(ram_at_level.begin(), ram_at_level.end(), [&](size_t a, size_t b){
+        return (uint64_t)logic_ram_list[a].get_lram_depth() * logic_ram_list[a].get_lram_width() >
+               (uint64_t)logic_ram_list[b].get_lram_depth() * logic_ram_list[b].get_lram_width();
+    });
+    //the area only grows with blocks and extra LUT blocks, so a candidate is dropped when another one of the same
+    //resource needs no more of either (of two equal ones the first, lowest mapper id, is kept)
+    level_candidates.resize(num_rams);
+    open_extra_LB.assign(num_rams + 1, 0);
+    for(size_t level = 0; level < num_rams; level++){
+        uint32_t shape = 0;
+        cache.find_shape(logic_ram_list[ram_at_level[level]], shape);
+        const map_candidate* first = cache.shape_begin(shape);
+        const map_candidate* last = cache.shape_end(shape);
+        for(const map_candidate* candidate = first; candidate != last; candidate++){
+            bool dominated = false;
+            for(const map_candidate* other = first; other != last && !dominated; other++){
+                if(other == candidate || other->resource_index != candidate->resource_index){
+                    continue;
+                }
+                unsigned int other_blocks = other->serial * other->parallel;
+                unsigned int blocks = candidate->serial * candidate->parallel;
+                bool no_worse = other_blocks <= blocks && other->extra_LB <= candidate->extra_LB;
+                bool better = other_blocks < blocks || other->extra_LB < candidate->extra_LB;
+                dominated = no_worse && (better || other < candidate);
+            }
+            if(!dominated){
+                level_candidates[level].push_back(candidate);
+            }
+        }
+    }
+    for(size_t level = num_rams; level-- > 0;){
+        unsigned int fewest_extra_LB = level_candidates[level][0]->extra_LB;
+        for(auto candidate: level_candidates[level]){
+            fewest_extra_LB = min(fewest_extra_LB, candidate->extra_LB);
+        }
+        open_extra_LB[level] = open_extra_LB[level + 1] + fewest_extra_LB;
+    }
+}
+
+void exact_search::search(size_t level){
+    if((++visited_nodes & 1023) == 0 && chrono::steady_clock::now() >= deadline){
+        timed_out = true;
+    }
+    if(timed_out){
+        return;
+    }
+    if(level == ram_at_level.size()){
+        double area = counters.area();
+        if(area < best_area){
+            best_area = area;
+            best_list = current_list;
+        }
+        return;
+    }
+    //children are tried cheapest bound first, so good complete mappings are found early and prune the rest
+    vector<pair<double, const map_candidate*> > child_list;
+    child_list.reserve(level_candidates[level].size());
+    counters.add_logic_LB(open_extra_LB[level + 1]);
+    for(auto candidate: level_candidates[level]){
+        counters.add(*candidate);
+        double bound = counters.area();
+        counters.remove(*candidate);
+        if(bound < best_area){
+            child_list.push_back(make_pair(bound, candidate));
+        }
+    }
+    counters.remove_logic_LB(open_extra_LB[level + 1]);
+    stable_sort(child_list.begin(), child_list.end(), [](const pair<double, const map_candidate*>& a,
+                                                         const pair<double, const map_candidate*>& b){
+        return a.first < b.first;
+    });
+    for(auto& child: child_list){
+        if(child.first >= best_area){
+            break;
+        }
+        counters.add(*child.second);
+        current_list[ram_at_level[level]] = child.second;
+        search(level + 1);
+        counters.remove(*child.second);
+    }
+}
+
+void map_exact(const vector<circuit>& logic_circuit_list, const vector<resource>& resource_list,
+        const area_model& model, const candidate_cache& cache, vector<mapping_result>& result_list,
+        const mapper_options& options){
+    vector<size_t> job_order;
+    for(size_t i : largest_circuit_first(logic_circuit_list)){
+        size_t num_rams = logic_circuit_list[i].get_ram_list().size();
+        if(num_rams > 0 && num_rams <= options.exact_ram_limit){
+            job_order.push_back(i);
+        }
+    }
+    run_parallel_jobs(job_order, options.num_threads, [&](size_t i){
+        const circuit& circuit = logic_circuit_list[i];
+        mapping_result& result = result_list[i];
+        auto deadline = chrono::steady_clock::now() + chrono::microseconds((long long)(options.exact_time_ms * 1000));
+        exact_search search(circuit, model, cache, result, deadline);
+        double seed_area = search.best_area;
+        bool finished = search.run();
+        result.proven_optimal = finished;
+        ostringstream circuit_log;
+        circuit_log<<"circuit: "<<circuit.get_circuit_id()<<" exact search ";
+        if(search.best_area < seed_area){
+            string usage = rewrite_mapping(circuit, resource_list, model, search.best_list, search.best_area, result);
+            circuit_log<<(finished ? "found the optimum " : "timed out, best found ")<<usage<<", area is: "
+                       <<search.best_area<<" (greedy seed: "<<seed_area<<")"<<endl;
+        }else{
+            circuit_log<<(finished ? "proved the greedy seed optimal" : "timed out, kept the greedy seed")
+                       <<", area is: "<<seed_area<<endl;
+        }
+        result.summary += circuit_log.str();
+    });
+}
@@ -0,0 +1,15 @@
+#ifndef LAB3_IMPLEMENTATION_EXACT_H
+#define LAB3_IMPLEMENTATION_EXACT_H
+
+#include "refine.h"
+
+//branch and bound over every cached candidate of every ram, for circuits with at most exact_ram_limit rams,
+//one circuit per job. a partial assignment is pruned when the area of its counters, with the fewest extra LUT
+//blocks of every ram still open, is not below the best complete mapping found; the greedy result is the first
+//incumbent. a search that finishes proves its circuit optimal, one that runs past exact_time_ms keeps the best
+//mapping found so far, which is never worse than the greedy one
+void map_exact(const vector<circuit>& logic_circuit_list, const vector<resource>& resource_list,
+        const area_model& model, const candidate_cache& cache, vector<mapping_result>& result_list,
+        const mapper_options& options);
+
+#endif //LAB3_IMPLEMENTATION_EXACT_H
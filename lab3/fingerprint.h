@@ -0,0 +1,22 @@
+#ifndef LAB3_IMPLEMENTATION_FINGERPRINT_H
+#define LAB3_IMPLEMENTATION_FINGERPRINT_H
+
+#include <cstddef>
+#include <cstdint>
+
+//the 64 bit FNV-1a hash behind every fingerprint and checksum of the state files and the sweep checkpoint
+const uint64_t FNV1A_OFFSET = 14695981039346656037ULL;
+const uint64_t FNV1A_PRIME = 1099511628211ULL;
+
+//one step of the hash, start from FNV1A_OFFSET
+inline void fnv1a(uint64_t& hash, const void* bytes, size_t length){
+    for(size_t i = 0; i < length; i++){
+        hash ^= ((const unsigned char*)bytes)[i];
+        hash *= FNV1A_PRIME;
+    }
+}
+
+//version of the sweep's area records, in the state file and in the checkpoint alike
+const uint32_t AREA_STATE_VERSION = 1;
+
+#endif //LAB3_IMPLEMENTATION_FINGERPRINT_H
@@ -0,0 +1,82 @@
+#ifndef LAB3_IMPLEMENTATION_FIXED_LAYOUT_H
+#define LAB3_IMPLEMENTATION_FIXED_LAYOUT_H
+
+#include "score.h"
+
+//resource layouts for the greedy mapper, one struct per layout_kind. map_circuit and its scoring kernels
+//(score_ram_layout, score_ram_simd) are templates over them. a fixed layout makes the number of resources and
+//which one is LUTRAM compile-time constants, and for Stratix-IV the LB ratios and the area per logic block too:
+//the block counters live on the stack, the kernels read no table the layout fixes (no resource column at all
+//with a single resource), the AVX2 registers are constants and the divisions by the ratios become
+//multiplications. every layout prices a candidate with the same operations in the same order as area_model, so
+//the areas and choices are bit for bit the generic ones. the candidate lists are not fixed here: they depend on
+//the logical ram shapes of the input and stay in the candidate cache
+
+//any resource table, everything is read from the kernel's tables and the area_model
+struct generic_layout {
+    static const size_t num_resources = 0; //not known until run time
+    static uint32_t block_ratio(const ram_scoring& ram, uint32_t r){ return ram.block_ratio[r]; }
+    static uint32_t lutram_block(const ram_scoring& ram, uint32_t r){ return ram.lutram_block[r]; }
+    static double area_for_LB(const area_model& model, unsigned int LBrequired){ return model.area_for_LB(LBrequired); }
+};
+
+//LUTRAM, 8192 bit BRAM, 128k BRAM of ./mapping 1
+struct stratix_iv_layout {
+    static const size_t num_resources = 3;
+    static constexpr uint32_t block_ratio(const ram_scoring&, uint32_t r){ return r == 1 ? 10 : (r == 2 ? 300 : 0); }
+    static constexpr uint32_t lutram_block(const ram_scoring&, uint32_t r){ return r == 0 ? 1 : 0; }
+    static double area_for_LB(const area_model& model, unsigned int LBrequired){
+        double area = LBrequired * STRATIX_IV_LB_AREA;
+        area += (int)(LBrequired / 10u) * model.get_bram_area(0);
+        area += (int)(LBrequired / 300u) * model.get_bram_area(1);
+        return area;
+    }
+};
+
+//the BRAM of ./mapping 2, or of ./mapping 3 followed by its LUTRAM; the ratio is only known at run time
+template <bool WITH_LUTRAM>
+struct single_bram_layout {
+    static const size_t num_resources = WITH_LUTRAM ? 2 : 1;
+    static uint32_t block_ratio(const ram_scoring& ram, uint32_t r){ return r == 0 ? ram.block_ratio[0] : 0; }
+    static constexpr uint32_t lutram_block(const ram_scoring&, uint32_t r){ return r == 1 ? 1 : 0; }
+    static double area_for_LB(const area_model& model, unsigned int LBrequired){
+        double area = LBrequired * model.get_lb_area();
+        area += (int)(LBrequired / model.get_block_ratio(0)) * model.get_bram_area(0);
+        return area;
+    }
+};
+
+//logic blocks required by a candidate, resource_LB and candidate_LB with the layout's constants
+template <typename layout>
+inline uint32_t layout_resource_LB(const ram_scoring& ram, uint32_t r, uint32_t blocks, uint32_t extra_LB){
+    uint32_t LBrequired = ram.logic_LB + extra_LB + layout::lutram_block(ram, r) * blocks;
+    uint32_t bram_LB = (ram.used_blocks[r] + blocks) * layout::block_ratio(ram, r);
+    return LBrequired > bram_LB ? LBrequired : bram_LB;
+}
+
+template <typename layout>
+inline uint32_t layout_candidate_LB(const ram_scoring& ram, uint32_t i){
+    return layout_resource_LB<layout>(ram, layout::num_resources == 1 ? 0 : ram.resource[i], ram.blocks[i], ram.extra_LB[i]);
+}
+
+//the scalar loop of score_ram_scalar for one layout, inlined into the greedy
+template <typename layout>
+inline uint32_t score_ram_layout(const ram_scoring& ram, uint32_t& best_LB){
+    uint32_t best = 0;
+    best_LB = layout_candidate_LB<layout>(ram, 0);
+    for(uint32_t i = 1; i < ram.count; i++){
+        uint32_t LB = layout_candidate_LB<layout>(ram, i);
+        if(LB < best_LB){
+            best_LB = LB;
+            best = i;
+        }
+    }
+    return best;
+}
+
+//the AVX2 kernel for one layout (score.cpp has the instantiations for the layouts above); the scalar loop when
+//the AVX2 kernel is not built in, call it only when simd_scoring_enabled()
+template <typename layout>
+uint32_t score_ram_simd(const ram_scoring& ram, uint32_t& best_LB);
+
+#endif //LAB3_IMPLEMENTATION_FIXED_LAYOUT_H
@@ -0,0 +1,281 @@
+#include "incremental.h"
+#include "input_parser.h"
+#include "output_writer.h"
+#include "report.h"
+#include <unistd.h>
+
+static const char MAPPING_STATE_MAGIC[8] = {'L', 'A', 'B', '3', 'S', 'T', 'A', 'T'};
+static const char AREA_STATE_MAGIC[8] = {'L', 'A', 'B', '3', 'S', 'W', 'P', 'S'};
+static const uint32_t STATE_ENDIAN_TAG = 0x01020304;
+
+static void fnv1a_uint(uint64_t& hash, uint64_t value){
+    fnv1a(hash, &value, sizeof(value));
+}
+
+uint64_t circuit_fingerprint(const circuit& circuit){
+    uint64_t hash = FNV1A_OFFSET;
+    fnv1a_uint(hash, circuit.get_circuit_num_lb());
+    fnv1a_uint(hash, circuit.get_ram_list().size());
+    for(auto& logicram: circuit.get_ram_list()){
+        fnv1a_uint(hash, logicram.get_lram_id());
+        fnv1a_uint(hash, logicram.get_lram_mode());
+        fnv1a_uint(hash, logicram.get_lram_depth());
+        fnv1a_uint(hash, logicram.get_lram_width());
+    }
+    return hash;
+}
+
+uint64_t architecture_fingerprint(const vector<resource>& resource_list, const area_model& model,
+        const mapper_options& options){
+    ostringstream description;
+    description.precision(17);
+    description<<model.get_lb_area()<<";";
+    for(auto& physical_ram: resource_list){
+        description<<physical_ram.get_pram_type()<<" "<<physical_ram.get_ratio()<<" "<<physical_ram.get_pram_size()<<" "
+                   <<physical_ram.get_tdp_max_width()<<" "<<physical_ram.get_block_area()<<" "
+                   <<physical_ram.get_output_type()<<" "<<physical_ram.get_label();
+        for(auto& dw_pair: physical_ram.get_comb_list()){
+            description<<" "<<dw_pair.first<<"x"<<dw_pair.second;
+        }
+        description<<";";
+    }
+    //the refinement budget is left out on purpose: it is a time limit, any run's result is as good to keep
+    description<<options.portfolio_size<<" "<<options.exact_ram_limit<<" "<<options.exact_time_ms<<" "
+               <<(options.refine_budget_ms > 0);
+    uint64_t hash = FNV1A_OFFSET;
+    string text = description.str();
+    fnv1a(hash, text.data(), text.size());
+    return hash;
+}
+
+bool mapping_state::load(const string& state_file, uint64_t arch_fingerprint){
+    circuit_records.clear();
+    mapped_storage.clear();
+    record_index.clear();
+    mapped_file state;
+    if(!state.open_file(state_file) || state.get_length() < sizeof(mapping_state_header)){
+        return false;
+    }
+    mapping_state_header header;
+    memcpy(&header, state.get_begin(), sizeof(header));
+    if(memcmp(header.magic, MAPPING_STATE_MAGIC, sizeof(header.magic)) != 0 ||
+       header.version != MAPPING_STATE_VERSION || header.endian_tag != STATE_ENDIAN_TAG ||
+       header.arch_fingerprint != arch_fingerprint ||
+       header.num_circuits > state.get_length() / sizeof(mapping_state_circuit) ||
+       header.num_mapped > state.get_length() / sizeof(mapping_state_ram) ||
+       sizeof(header) + header.num_circuits * sizeof(mapping_state_circuit) + header.num_mapped * sizeof(mapping_state_ram) !=
+       state.get_length()){
+        return false;
+    }
+    const char* circuit_section = state.get_begin() + sizeof(header);
+    circuit_records.resize(header.num_circuits);
+    memcpy(circuit_records.data(), circuit_section, header.num_circuits * sizeof(mapping_state_circuit));
+    const char* mapped_section = circuit_section + header.num_circuits * sizeof(mapping_state_circuit);
+    mapped_storage.resize(header.num_mapped);
+    for(size_t i = 0; i < header.num_mapped; i++){
+        mapping_state_ram record;
+        memcpy(&record, mapped_section + i * sizeof(record), sizeof(record));
+        mapped_storage[i] = mappedRam(record.ram_id, record.mapper_id, record.additional_lut, record.logic_depth,
+                record.logic_width, record.serial, record.parallel, record.type, (ramMode)record.lram_mode,
+                record.mapped_depth, record.mapped_width, record.cost);
+    }
+    for(size_t i = 0; i < circuit_records.size(); i++){
+        const mapping_state_circuit& record = circuit_records[i];
+        if(record.mapped_offset > header.num_mapped || record.mapped_count > header.num_mapped - record.mapped_offset){
+            circuit_records.clear();
+            mapped_storage.clear();
+            record_index.clear();
+            return false;
+        }
+        record_index[record.circuit_id] = i;
+    }
+    return true;
+}
+
+//written under a temporary name and renamed, so a crash never leaves a half written state behind
+static bool replace_file(const string& file_name, const string& content){
+    string temp_file = file_name + ".tmp" + to_string(getpid());
+    output_buffer outs;
+    if(!outs.open_file(temp_file)){
+        return false;
+    }
+    outs.append_raw(content.data(), content.size());
+    if(!outs.close_file() || rename(temp_file.c_str(), file_name.c_str()) != 0){
+        unlink(temp_file.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool write_mapping_state(const string& state_file, uint64_t arch_fingerprint, const vector<circuit>& logic_circuit_list,
+        const vector<uint64_t>& fingerprint_list){
+    mapping_state_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAPPING_STATE_MAGIC, sizeof(header.magic));
+    header.version = MAPPING_STATE_VERSION;
+    header.endian_tag = STATE_ENDIAN_TAG;
+    header.arch_fingerprint = arch_fingerprint;
+    header.num_circuits = logic_circuit_list.size();
+    header.num_mapped = 0;
+    for(auto& circuit: logic_circuit_list){
+        header.num_mapped += circuit.get_mapped_list().size();
+    }
+    string content((const char*)&header, sizeof(header));
+    uint64_t mapped_offset = 0;
+    for(size_t i = 0; i < logic_circuit_list.size(); i++){
+        mapping_state_circuit record;
+        memset(&record, 0, sizeof(record));
+        record.circuit_id = logic_circuit_list[i].get_circuit_id();
+        record.fingerprint = fingerprint_list[i];
+        record.area = logic_circuit_list[i].get_circuit_area();
+        record.mapped_offset = mapped_offset;
+        record.mapped_count = logic_circuit_list[i].get_mapped_list().size();
+        mapped_offset += record.mapped_count;
+        content.append((const char*)&record, sizeof(record));
+    }
+    for(auto& circuit: logic_circuit_list){
+        for(auto& mapped: circuit.get_mapped_list()){
+            mapping_state_ram record;
+            memset(&record, 0, sizeof(record));
+            record.cost = mapped.get_total_cost();
+            record.ram_id = mapped.get_ram_id();
+            record.mapper_id = mapped.get_mapper_id();
+            record.additional_lut = mapped.get_lut();
+            record.logic_depth = mapped.get_ldepth();
+            record.logic_width = mapped.get_lwidth();
+            record.parallel = mapped.get_p();
+            record.mapped_depth = mapped.get_pdepth();
+            record.mapped_width = mapped.get_pwidth();
+            record.serial = (uint8_t)mapped.get_s();
+            record.type = (uint8_t)mapped.get_map_type();
+            record.lram_mode = (uint8_t)mapped.get_lram_mode();
+            content.append((const char*)&record, sizeof(record));
+        }
+    }
+    return replace_file(state_file, content);
+}
+
+void perform_incremental_mapper(vector<circuit>& logic_circuit_list, const vector<resource>& resource_list,
+        const area_model& model, const mapper_options& options, mapping_arena& arena, const string& state_file,
+        vector<uint64_t>& fingerprint_list){
+    mapping_state state;
+    bool have_state = state.load(state_file, architecture_fingerprint(resource_list, model, options));
+    //only the circuits without a stored result go through the mapper, as circuits of their own
+    vector<circuit> changed_list;
+    vector<size_t> changed_index;
+    vector<const mapping_state_circuit*> stored_list(logic_circuit_list.size(), NULL);
+    fingerprint_list.resize(logic_circuit_list.size());
+    for(size_t i = 0; i < logic_circuit_list.size(); i++){
+        const circuit& circuit = logic_circuit_list[i];
+        fingerprint_list[i] = circuit_fingerprint(circuit);
+        if(have_state){
+            stored_list[i] = state.find(circuit.get_circuit_id(), fingerprint_list[i]);
+        }
+        if(stored_list[i] == NULL){
+            changed_list.push_back(::circuit(circuit.get_circuit_id(), circuit.get_circuit_num_lb()));
+            changed_list.back().set_ram_list(circuit.get_ram_list().begin(), circuit.get_ram_list().size());
+            changed_index.push_back(i);
+        }
+    }
+    if(options.report != NULL){
+        options.report->last_point().circuit_list.resize(changed_list.size());
+    }
+    mapping_arena changed_arena;
+    if(!changed_list.empty()){
+        perform_core_mapper(changed_list, resource_list, model, options, changed_arena);
+    }
+    //the mapper reported the changed circuits in changed_list order, every circuit gets its own slot back
+    if(options.report != NULL){
+        vector<circuit_report>& report_list = options.report->last_point().circuit_list;
+        vector<circuit_report> changed_report_list;
+        changed_report_list.swap(report_list);
+        report_list.resize(logic_circuit_list.size());
+        for(size_t j = 0; j < changed_list.size(); j++){
+            report_list[changed_index[j]] = changed_report_list[j];
+        }
+        for(size_t i = 0; i < logic_circuit_list.size(); i++){
+            if(stored_list[i] != NULL){
+                fill_kept_circuit_report(logic_circuit_list[i], resource_list, model, state.mapped_begin(*stored_list[i]),
+                                         stored_list[i]->mapped_count, report_list[i]);
+            }
+        }
+    }
+
+    //the re-mapped and the stored rows are both copied to the circuit's rows of the caller's arena
+    vector<size_t> offset_list = circuit_row_offsets(logic_circuit_list);
+    arena.reserve_rows(offset_list.back());
+    for(size_t j = 0; j < changed_list.size(); j++){
+        circuit& circuit = logic_circuit_list[changed_index[j]];
+        const_span<mappedRam> mapped_list = changed_list[j].get_mapped_list();
+        mappedRam* rows = arena.get_mapped_row(offset_list[changed_index[j]]);
+        copy(mapped_list.begin(), mapped_list.end(), rows);
+        circuit.set_mapped_list(rows, mapped_list.size());
+        circuit.set_circuit_area(changed_list[j].get_circuit_area());
+    }
+    for(size_t i = 0; i < logic_circuit_list.size(); i++){
+        const mapping_state_circuit* stored = stored_list[i];
+        if(stored == NULL){
+            continue;
+        }
+        circuit& circuit = logic_circuit_list[i];
+        mappedRam* rows = arena.get_mapped_row(offset_list[i]);
+        copy(state.mapped_begin(*stored), state.mapped_begin(*stored) + stored->mapped_count, rows);
+        circuit.set_mapped_list(rows, stored->mapped_count);
+        circuit.set_circuit_area(stored->area);
+        cout<<"circuit: "<<circuit.get_circuit_id()<<" is unchanged, kept its mapping with area: "<<stored->area<<endl;
+    }
+    cout<<"Re-mapped "<<changed_list.size()<<" of "<<logic_circuit_list.size()<<" circuits, the others are kept from "
+        <<state_file<<endl;
+}
+
+uint64_t job_fingerprint(uint64_t arch_fingerprint, uint64_t circuit_fingerprint){
+    uint64_t hash = FNV1A_OFFSET;
+    fnv1a_uint(hash, arch_fingerprint);
+    fnv1a_uint(hash, circuit_fingerprint);
+    return hash;
+}
+
+bool load_area_state(const string& state_file, unordered_map<uint64_t, double>& area_by_job){
+    area_by_job.clear();
+    mapped_file state;
+    size_t header_size = sizeof(AREA_STATE_MAGIC) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+    if(!state.open_file(state_file) || state.get_length() < header_size){
+        return false;
+    }
+    const char* pos = state.get_begin();
+    uint32_t version, endian_tag;
+    uint64_t count;
+    memcpy(&version, pos + sizeof(AREA_STATE_MAGIC), sizeof(version));
+    memcpy(&endian_tag, pos + sizeof(AREA_STATE_MAGIC) + sizeof(version), sizeof(endian_tag));
+    memcpy(&count, pos + sizeof(AREA_STATE_MAGIC) + 2 * sizeof(uint32_t), sizeof(count));
+    if(memcmp(pos, AREA_STATE_MAGIC, sizeof(AREA_STATE_MAGIC)) != 0 || version != AREA_STATE_VERSION ||
+       endian_tag != STATE_ENDIAN_TAG || count > state.get_length() / 16 || header_size + count * 16 != state.get_length()){
+        return false;
+    }
+    pos += header_size;
+    area_by_job.reserve(count);
+    for(uint64_t i = 0; i < count; i++, pos += 16){
+        uint64_t key;
+        double area;
+        memcpy(&key, pos, sizeof(key));
+        memcpy(&area, pos + sizeof(key), sizeof(area));
+        area_by_job[key] = area;
+    }
+    return true;
+}
+
+//magic, version, endian tag and record count, then one (job fingerprint, area) pair of 16 bytes per job
+bool write_area_state(const string& state_file, const unordered_map<uint64_t, double>& area_by_job){
+    uint32_t version = AREA_STATE_VERSION;
+    uint32_t endian_tag = STATE_ENDIAN_TAG;
+    uint64_t count = area_by_job.size();
+    string content(AREA_STATE_MAGIC, sizeof(AREA_STATE_MAGIC));
+    content.append((const char*)&version, sizeof(version));
+    content.append((const char*)&endian_tag, sizeof(endian_tag));
+    content.append((const char*)&count, sizeof(count));
+    for(auto& job: area_by_job){
+        content.append((const char*)&job.first, sizeof(job.first));
+        content.append((const char*)&job.second, sizeof(job.second));
+    }
+    return replace_file(state_file, content);
+}
@@ -0,0 +1,96 @@
+#ifndef LAB3_IMPLEMENTATION_INCREMENTAL_H
+#define LAB3_IMPLEMENTATION_INCREMENTAL_H
+
+#include "circuit.h"
+#include "fingerprint.h"
+
+//64 bit FNV-1a of one circuit's logic block count and logical RAM list (id, mode, depth, width of every ram)
+uint64_t circuit_fingerprint(const circuit& circuit);
+
+//64 bit FNV-1a of everything besides the circuit that decides its mapping: the resource table (geometry, ratios,
+//TDP widths, block areas, output types), the logic block tile area and the mapper options that change results
+uint64_t architecture_fingerprint(const vector<resource>& resource_list, const area_model& model,
+        const mapper_options& options);
+
+//layout of the mapping state kept next to a mapping file: header, one record per circuit, then the mapped rams
+//of every circuit in mapping file order
+const uint32_t MAPPING_STATE_VERSION = 2;
+
+struct mapping_state_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_tag;
+    uint64_t arch_fingerprint;
+    uint64_t num_circuits;
+    uint64_t num_mapped;
+};
+
+struct mapping_state_circuit {
+    uint32_t circuit_id;
+    uint32_t padding;
+    uint64_t fingerprint;
+    double area;
+    uint64_t mapped_offset;
+    uint64_t mapped_count;
+};
+
+//one mapped ram of the state file, the fields of mappedRam in a fixed on-disk layout with the padding zeroed
+struct mapping_state_ram {
+    double cost;
+    uint32_t ram_id;
+    uint32_t mapper_id;
+    uint32_t additional_lut;
+    uint32_t logic_depth;
+    uint32_t logic_width;
+    uint32_t parallel;
+    uint32_t mapped_depth;
+    uint32_t mapped_width;
+    uint8_t serial;
+    uint8_t type;
+    uint8_t lram_mode; //ramMode value
+    uint8_t reserved[5];
+};
+
+static_assert(sizeof(mapping_state_ram) == 48, "mapping_state_ram is a fixed on-disk layout");
+
+//results of the previous run of one architecture, looked up by circuit id and fingerprint
+class mapping_state {
+private:
+    vector<mapping_state_circuit> circuit_records;
+    vector<mappedRam> mapped_storage;
+    unordered_map<uint32_t, size_t> record_index;
+public:
+    //false when the file is missing, damaged or was written for another architecture
+    bool load(const string& state_file, uint64_t arch_fingerprint);
+    const mapping_state_circuit* find(uint32_t circuit_id, uint64_t fingerprint) const {
+        auto found = record_index.find(circuit_id);
+        if(found == record_index.end() || circuit_records[found->second].fingerprint != fingerprint){
+            return NULL;
+        }
+        return &circuit_records[found->second];
+    }
+    const mappedRam* mapped_begin(const mapping_state_circuit& record) const {
+        return mapped_storage.data() + record.mapped_offset;
+    }
+};
+
+bool write_mapping_state(const string& state_file, uint64_t arch_fingerprint, const vector<circuit>& logic_circuit_list,
+        const vector<uint64_t>& fingerprint_list);
+
+//perform_core_mapper for the circuits whose fingerprint is not in the state file of the previous run; every
+//other circuit gets its stored mapping and area back, so the mapping file is written as if all were re-mapped.
+//fingerprint_list receives the fingerprint of every circuit, for write_mapping_state once the output is written.
+//the mapped rams of all circuits, re-mapped or kept, end up in arena as for perform_core_mapper
+void perform_incremental_mapper(vector<circuit>& logic_circuit_list, const vector<resource>& resource_list,
+        const area_model& model, const mapper_options& options, mapping_arena& arena, const string& state_file,
+        vector<uint64_t>& fingerprint_list);
+
+//areas of sweep jobs, keyed by the fingerprint of the (architecture point, circuit) pair
+
+uint64_t job_fingerprint(uint64_t arch_fingerprint, uint64_t circuit_fingerprint);
+
+bool load_area_state(const string& state_file, unordered_map<uint64_t, double>& area_by_job);
+
+bool write_area_state(const string& state_file, const unordered_map<uint64_t, double>& area_by_job);
+
+#endif //LAB3_IMPLEMENTATION_INCREMENTAL_H
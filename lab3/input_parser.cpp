@@ -0,0 +1,547 @@
+#include "input_parser.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstring>
+
+bool mapped_file::open_file(const string& file_name){
+    close_file();
+    fd = open(file_name.c_str(), O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0){
+        close_file();
+        return false;
+    }
+    length = file_stat.st_size;
+    if(length == 0){
+        //nothing to map, an empty file simply has no lines
+        return true;
+    }
+    void* mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    if(mapped == MAP_FAILED){
+        length = 0;
+        close_file();
+        return false;
+    }
+    madvise(mapped, length, MADV_SEQUENTIAL);
+    data = (const char*)mapped;
+    return true;
+}
+
+void mapped_file::close_file(){
+    if(data != NULL){
+        munmap((void*)data, length);
+        data = NULL;
+    }
+    length = 0;
+    if(fd >= 0){
+        close(fd);
+        fd = -1;
+    }
+}
+
+//walks a mapped file (or one line read from a stream) line by line and hands out the whitespace separated
+//tokens of the current line
+class line_scanner {
+private:
+    const char* pos;
+    const char* end;
+    const char* line_end;
+    const char* next_line_begin;
+    unsigned long line_number;
+public:
+    line_scanner(const mapped_file& file){
+        pos = file.get_begin();
+        end = file.get_end();
+        line_end = pos;
+        next_line_begin = pos;
+        line_number = 0;
+    }
+    //text that starts at line first_line of its file
+    line_scanner(const char* begin, const char* i_end, unsigned long first_line){
+        pos = begin;
+        end = i_end;
+        line_end = pos;
+        next_line_begin = pos;
+        line_number = first_line - 1;
+    }
+    //move to the next line, returns false at the end of the file
+    bool next_line(){
+        if(next_line_begin >= end){
+            return false;
+        }
+        pos = next_line_begin;
+        line_end = (const char*)memchr(pos, '\n', end - pos);
+        if(line_end == NULL){
+            line_end = end;
+            next_line_begin = end;
+        }else{
+            next_line_begin = line_end + 1;
+        }
+        line_number++;
+        return true;
+    }
+    bool next_token(const char*& token, size_t& token_length){
+        while(pos < line_end && (*pos == ' ' || *pos == '\t' || *pos == '\r')){
+            pos++;
+        }
+        if(pos == line_end){
+            return false;
+        }
+        token = pos;
+        while(pos < line_end && *pos != ' ' && *pos != '\t' && *pos != '\r'){
+            pos++;
+        }
+        token_length = pos - token;
+        return true;
+    }
+    bool is_blank(){
+        const char* token;
+        size_t token_length;
+        const char* saved = pos;
+        bool blank = !next_token(token, token_length);
+        pos = saved;
+        return blank;
+    }
+    unsigned long get_line_number() const { return line_number; }
+};
+
+static bool parse_uint(const char* token, size_t token_length, unsigned int& value){
+    if(token_length == 0 || token_length > 10){
+        return false;
+    }
+    unsigned long long number = 0;
+    for(size_t i = 0; i < token_length; i++){
+        if(token[i] < '0' || token[i] > '9'){
+            return false;
+        }
+        number = number * 10 + (token[i] - '0');
+    }
+    if(number > 0xFFFFFFFFULL){
+        return false;
+    }
+    value = (unsigned int)number;
+    return true;
+}
+
+static bool parse_mode(const char* token, size_t token_length, ramMode& mode){
+    static const ramMode mode_list[] = {SimpleDualPort, ROM, SinglePort, TrueDualPort};
+    for(auto candidate: mode_list){
+        const char* name = ram_mode_name(candidate);
+        if(strlen(name) == token_length && memcmp(name, token, token_length) == 0){
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool report_error(const string& file_name, unsigned long line_number, const string& message){
+    cout<<file_name<<":"<<line_number<<": "<<message<<endl;
+    return false;
+}
+
+//read the next token of the line as an unsigned number, reporting which field was wrong
+static bool read_field(line_scanner& scanner, const string& file_name, const char* field_name, unsigned int& value){
+    const char* token;
+    size_t token_length;
+    if(!scanner.next_token(token, token_length)){
+        return report_error(file_name, scanner.get_line_number(), string("missing ") + field_name);
+    }
+    if(!parse_uint(token, token_length, value)){
+        return report_error(file_name, scanner.get_line_number(), string("invalid ") + field_name + " \"" +
+                            string(token, token_length) + "\"");
+    }
+    return true;
+}
+
+//first field of a line; blank lines are reported through is_blank and skipped by the callers
+static bool read_first_field(line_scanner& scanner, const string& file_name, const char* field_name,
+                             unsigned int& value, bool& is_blank){
+    const char* token;
+    size_t token_length;
+    is_blank = !scanner.next_token(token, token_length);
+    if(is_blank){
+        return true;
+    }
+    if(!parse_uint(token, token_length, value)){
+        return report_error(file_name, scanner.get_line_number(), string("invalid ") + field_name + " \"" +
+                            string(token, token_length) + "\"");
+    }
+    return true;
+}
+
+static bool expect_line_end(line_scanner& scanner, const string& file_name){
+    if(!scanner.is_blank()){
+        return report_error(file_name, scanner.get_line_number(), "unexpected extra field");
+    }
+    return true;
+}
+
+//the rest of a logical ram line after its circuit id: ram id, mode, depth and width
+static bool parse_ram_fields(line_scanner& scanner, const string& file_name, logicRam& logicram){
+    unsigned int lram_id, lram_d, lram_w;
+    ramMode actual_mode;
+    const char* token;
+    size_t token_length;
+    if(!read_field(scanner, file_name, "ram id", lram_id)){
+        return false;
+    }
+    if(!scanner.next_token(token, token_length)){
+        return report_error(file_name, scanner.get_line_number(), "missing ram mode");
+    }
+    if(!parse_mode(token, token_length, actual_mode)){
+        return report_error(file_name, scanner.get_line_number(), "unknown ram mode \"" +
+                            string(token, token_length) + "\"");
+    }
+    if(!read_field(scanner, file_name, "depth", lram_d) ||
+       !read_field(scanner, file_name, "width", lram_w) ||
+       !expect_line_end(scanner, file_name)){
+        return false;
+    }
+    if(lram_d == 0 || lram_w == 0){
+        return report_error(file_name, scanner.get_line_number(), "depth and width should be positive");
+    }
+    logicram = logicRam(lram_id, actual_mode, lram_d, lram_w);
+    return true;
+}
+
+//logic block counts, after one header line; circuit ids have to be 0, 1, 2, ... in order
+static bool parse_logic_block_file(const string& logic_bc_file, vector<circuit>& logic_circuit_list){
+    mapped_file bc_file;
+    if(!bc_file.open_file(logic_bc_file)){
+        cout<<"Cannot open the logic block count file: "<<logic_bc_file<<endl;
+        return false;
+    }
+    line_scanner bc_scanner(bc_file);
+    bc_scanner.next_line();
+    while(bc_scanner.next_line()){
+        unsigned int bc_id, bc_num;
+        bool is_blank;
+        if(!read_first_field(bc_scanner, logic_bc_file, "circuit id", bc_id, is_blank)){
+            return false;
+        }
+        if(is_blank){
+            continue;
+        }
+        if(!read_field(bc_scanner, logic_bc_file, "logic block count", bc_num) ||
+           !expect_line_end(bc_scanner, logic_bc_file)){
+            return false;
+        }
+        if(bc_id != logic_circuit_list.size()){
+            return report_error(logic_bc_file, bc_scanner.get_line_number(), "circuit id " + to_string(bc_id) +
+                                " is out of order, expected " + to_string(logic_circuit_list.size()));
+        }
+        logic_circuit_list.push_back(circuit(bc_id, bc_num));
+    }
+    return true;
+}
+
+bool parse_input(benchmark_set& benchmark, const string& logic_rams_file, const string& logic_bc_file){
+    //---------------------parsing the txt file---------------
+    vector<circuit>& logic_circuit_list = benchmark.get_circuit_list();
+    vector<logicRam>& ram_storage = benchmark.get_ram_storage();
+    benchmark.clear();
+    if(!parse_logic_block_file(logic_bc_file, logic_circuit_list)){
+        return false;
+    }
+    mapped_file rams_file;
+    if(!rams_file.open_file(logic_rams_file)){
+        cout<<"Cannot open the logical ram file: "<<logic_rams_file<<endl;
+        return false;
+    }
+
+    //first pass over the logical rams (after two header lines) only counts the rams of every circuit,
+    //so all rams land in one array where every circuit owns a contiguous slice
+    vector<size_t> ram_count(logic_circuit_list.size(), 0);
+    line_scanner count_scanner(rams_file);
+    count_scanner.next_line();
+    count_scanner.next_line();
+    while(count_scanner.next_line()){
+        unsigned int circuit_number;
+        bool is_blank;
+        if(!read_first_field(count_scanner, logic_rams_file, "circuit id", circuit_number, is_blank)){
+            return false;
+        }
+        if(is_blank){
+            continue;
+        }
+        if(circuit_number >= logic_circuit_list.size()){
+            return report_error(logic_rams_file, count_scanner.get_line_number(), "circuit id " +
+                                to_string(circuit_number) + " is not listed in " + logic_bc_file);
+        }
+        ram_count[circuit_number]++;
+    }
+    vector<size_t> ram_slot(logic_circuit_list.size(), 0);
+    size_t total_rams = 0;
+    for(size_t i = 0; i < logic_circuit_list.size(); i++){
+        ram_slot[i] = total_rams;
+        total_rams += ram_count[i];
+    }
+    ram_storage.resize(total_rams);
+
+    line_scanner rams_scanner(rams_file);
+    rams_scanner.next_line();
+    rams_scanner.next_line();
+    while(rams_scanner.next_line()){
+        unsigned int circuit_number;
+        bool is_blank;
+        if(!read_first_field(rams_scanner, logic_rams_file, "circuit id", circuit_number, is_blank)){
+            return false;
+        }
+        if(is_blank){
+            continue;
+        }
+        if(!parse_ram_fields(rams_scanner, logic_rams_file, ram_storage[ram_slot[circuit_number]++])){
+            return false;
+        }
+    }
+    for(size_t i = 0; i < logic_circuit_list.size(); i++){
+        logic_circuit_list[i].set_ram_list(ram_storage.data() + ram_slot[i] - ram_count[i], ram_count[i]);
+    }
+    return true;
+}
+
+//---------------------binary benchmark cache---------------
+static const char BENCHMARK_CACHE_MAGIC[8] = {'L', 'A', 'B', '3', 'B', 'E', 'N', 'C'};
+static const uint32_t BENCHMARK_CACHE_ENDIAN_TAG = 0x01020304;
+
+//64 bit FNV-1a over the whole text file
+static uint64_t file_checksum(const mapped_file& file){
+    uint64_t hash = 14695981039346656037ULL;
+    for(const char* pos = file.get_begin(); pos < file.get_end(); pos++){
+        hash ^= (unsigned char)*pos;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static bool stat_source(const string& file_name, source_stamp& stamp){
+    struct stat file_stat;
+    if(stat(file_name.c_str(), &file_stat) != 0){
+        return false;
+    }
+    stamp.size = file_stat.st_size;
+    stamp.mtime_ns = (uint64_t)file_stat.st_mtim.tv_sec * 1000000000ULL + file_stat.st_mtim.tv_nsec;
+    stamp.checksum = 0;
+    return true;
+}
+
+//a source is unchanged when its size and modification time still match; a file that was only touched
+//(same size, new time) is still accepted when its content hashes to the stored checksum
+static bool source_unchanged(const string& file_name, const source_stamp& stored){
+    source_stamp current;
+    if(!stat_source(file_name, current) || current.size != stored.size){
+        return false;
+    }
+    if(current.mtime_ns == stored.mtime_ns){
+        return true;
+    }
+    mapped_file file;
+    return file.open_file(file_name) && file_checksum(file) == stored.checksum;
+}
+
+static size_t cache_ram_section_offset(uint64_t num_circuits){
+    size_t offset = sizeof(benchmark_cache_header) + num_circuits * sizeof(benchmark_cache_circuit);
+    return (offset + 7) & ~(size_t)7;
+}
+
+bool load_benchmark_cache(benchmark_set& benchmark, const string& cache_file, const string& logic_rams_file,
+        const string& logic_bc_file){
+    benchmark.clear();
+    mapped_file& cache_mapping = benchmark.get_cache_mapping();
+    if(!cache_mapping.open_file(cache_file) || cache_mapping.get_length() < sizeof(benchmark_cache_header)){
+        benchmark.clear();
+        return false;
+    }
+    benchmark_cache_header header;
+    memcpy(&header, cache_mapping.get_begin(), sizeof(header));
+    if(memcmp(header.magic, BENCHMARK_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+       header.version != BENCHMARK_CACHE_VERSION || header.endian_tag != BENCHMARK_CACHE_ENDIAN_TAG ||
+       header.num_circuits > cache_mapping.get_length() / sizeof(benchmark_cache_circuit) ||
+       header.num_rams > cache_mapping.get_length() / sizeof(logicRam) ||
+       cache_ram_section_offset(header.num_circuits) + header.num_rams * sizeof(logicRam) != cache_mapping.get_length() ||
+       !source_unchanged(logic_rams_file, header.rams_stamp) || !source_unchanged(logic_bc_file, header.bc_stamp)){
+        benchmark.clear();
+        return false;
+    }
+
+    //the circuits point straight into the mapped ram section, nothing is copied
+    const char* circuit_section = cache_mapping.get_begin() + sizeof(benchmark_cache_header);
+    const logicRam* ram_section = (const logicRam*)(cache_mapping.get_begin() +
+                                                    cache_ram_section_offset(header.num_circuits));
+    vector<circuit>& logic_circuit_list = benchmark.get_circuit_list();
+    logic_circuit_list.reserve(header.num_circuits);
+    for(uint64_t i = 0; i < header.num_circuits; i++){
+        benchmark_cache_circuit record;
+        memcpy(&record, circuit_section + i * sizeof(record), sizeof(record));
+        if(record.circuit_id != i || record.ram_offset > header.num_rams ||
+           record.ram_count > header.num_rams - record.ram_offset){
+            benchmark.clear();
+            return false;
+        }
+        logic_circuit_list.push_back(circuit(record.circuit_id, record.num_lb));
+        logic_circuit_list.back().set_ram_list(ram_section + record.ram_offset, record.ram_count);
+    }
+    return true;
+}
+
+bool write_benchmark_cache(benchmark_set& benchmark, const string& cache_file, const string& logic_rams_file,
+        const string& logic_bc_file){
+    benchmark_cache_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BENCHMARK_CACHE_MAGIC, sizeof(header.magic));
+    header.version = BENCHMARK_CACHE_VERSION;
+    header.endian_tag = BENCHMARK_CACHE_ENDIAN_TAG;
+    mapped_file rams_file;
+    mapped_file bc_file;
+    if(!stat_source(logic_rams_file, header.rams_stamp) || !stat_source(logic_bc_file, header.bc_stamp) ||
+       !rams_file.open_file(logic_rams_file) || !bc_file.open_file(logic_bc_file)){
+        return false;
+    }
+    header.rams_stamp.checksum = file_checksum(rams_file);
+    header.bc_stamp.checksum = file_checksum(bc_file);
+    vector<circuit>& logic_circuit_list = benchmark.get_circuit_list();
+    header.num_circuits = logic_circuit_list.size();
+    header.num_rams = benchmark.get_ram_count();
+
+    //written under a temporary name and renamed, so a concurrent reader never maps a half written cache
+    string temp_file = cache_file + ".tmp" + to_string(getpid());
+    ofstream outs(temp_file, ios::binary);
+    if(!outs){
+        return false;
+    }
+    outs.write((const char*)&header, sizeof(header));
+    uint64_t ram_offset = 0;
+    for(auto& circuit: logic_circuit_list){
+        benchmark_cache_circuit record;
+        record.circuit_id = circuit.get_circuit_id();
+        record.num_lb = circuit.get_circuit_num_lb();
+        record.ram_offset = ram_offset;
+        record.ram_count = circuit.get_ram_list().size();
+        ram_offset += record.ram_count;
+        outs.write((const char*)&record, sizeof(record));
+    }
+    static const char padding[8] = {0};
+    size_t table_end = sizeof(header) + logic_circuit_list.size() * sizeof(benchmark_cache_circuit);
+    outs.write(padding, cache_ram_section_offset(header.num_circuits) - table_end);
+    for(auto& circuit: logic_circuit_list){
+        const_span<logicRam> ram_list = circuit.get_ram_list();
+        outs.write((const char*)ram_list.begin(), ram_list.size() * sizeof(logicRam));
+    }
+    outs.close();
+    if(!outs || rename(temp_file.c_str(), cache_file.c_str()) != 0){
+        unlink(temp_file.c_str());
+        return false;
+    }
+    return true;
+}
+
+//use the binary cache when it still matches both text files, otherwise parse the text and refresh the cache;
+//an empty cache name turns the cache off
+bool load_benchmark(benchmark_set& benchmark, const string& logic_rams_file, const string& logic_bc_file,
+        const string& cache_file){
+    if(!cache_file.empty() && load_benchmark_cache(benchmark, cache_file, logic_rams_file, logic_bc_file)){
+        cout<<"Loaded "<<benchmark.get_ram_count()<<" logical rams from the benchmark cache "<<cache_file<<endl;
+        return true;
+    }
+    if(!parse_input(benchmark, logic_rams_file, logic_bc_file)){
+        return false;
+    }
+    if(!cache_file.empty() && !write_benchmark_cache(benchmark, cache_file, logic_rams_file, logic_bc_file)){
+        cout<<"Cannot write the benchmark cache "<<cache_file<<", continuing without it"<<endl;
+    }
+    return true;
+}
+
+//---------------------streamed logical rams---------------
+bool circuit_stream::open(const string& logic_rams_file, const string& logic_bc_file){
+    file_name = logic_rams_file == "-" ? "stdin" : logic_rams_file;
+    bc_file_name = logic_bc_file;
+    if(!parse_logic_block_file(logic_bc_file, circuit_list)){
+        return false;
+    }
+    streamed.assign(circuit_list.size(), false);
+    if(logic_rams_file == "-"){
+        input = &cin;
+    }else{
+        file.open(logic_rams_file);
+        if(!file){
+            cout<<"Cannot open the logical ram file: "<<logic_rams_file<<endl;
+            return false;
+        }
+        input = &file;
+    }
+    //two header lines, like parse_input
+    string line;
+    for(int i = 0; i < 2 && getline(*input, line); i++){
+        line_number++;
+    }
+    return true;
+}
+
+bool circuit_stream::read_ram(unsigned int& circuit_number, logicRam& logicram, bool& failed){
+    string line;
+    while(getline(*input, line)){
+        line_number++;
+        line_scanner scanner(line.data(), line.data() + line.size(), line_number);
+        scanner.next_line();
+        bool is_blank;
+        if(!read_first_field(scanner, file_name, "circuit id", circuit_number, is_blank)){
+            failed = true;
+            return false;
+        }
+        if(is_blank){
+            continue;
+        }
+        if(circuit_number >= circuit_list.size()){
+            report_error(file_name, line_number, "circuit id " + to_string(circuit_number) + " is not listed in " +
+                         bc_file_name);
+            failed = true;
+            return false;
+        }
+        if(!parse_ram_fields(scanner, file_name, logicram)){
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool circuit_stream::read_circuit(circuit& next_circuit, vector<logicRam>& ram_list, bool& failed){
+    failed = false;
+    unsigned int circuit_number;
+    logicRam logicram;
+    if(have_pending){
+        circuit_number = pending_circuit;
+        logicram = pending_ram;
+        have_pending = false;
+    }else if(!read_ram(circuit_number, logicram, failed)){
+        return false;
+    }
+    if(streamed[circuit_number]){
+        report_error(file_name, line_number, "the rams of circuit " + to_string(circuit_number) +
+                     " are not on consecutive lines, which -stream needs");
+        failed = true;
+        return false;
+    }
+    streamed[circuit_number] = true;
+    next_circuit = circuit_list[circuit_number];
+    ram_list.push_back(logicram);
+    unsigned int number;
+    while(read_ram(number, logicram, failed)){
+        if(number != circuit_number){
+            have_pending = true;
+            pending_circuit = number;
+            pending_ram = logicram;
+            return true;
+        }
+        ram_list.push_back(logicram);
+    }
+    return !failed;
+}
@@ -0,0 +1,124 @@
+#ifndef LAB3_IMPLEMENTATION_INPUT_PARSER_H
+#define LAB3_IMPLEMENTATION_INPUT_PARSER_H
+
+#include "circuit.h"
+
+//read-only memory mapping of a whole input file, unmapped when the object goes away
+class mapped_file {
+private:
+    const char* data;
+    size_t length;
+    int fd;
+public:
+    mapped_file(){
+        data = NULL;
+        length = 0;
+        fd = -1;
+    }
+    ~mapped_file(){ close_file(); }
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    bool open_file(const string& file_name);
+    void close_file();
+    const char* get_begin() const { return data; }
+    const char* get_end() const { return data + length; }
+    size_t get_length() const { return length; }
+};
+
+//every circuit of one benchmark set together with the storage behind their logical RAMs: either one array filled
+//by the text parser, or the RAM section of a memory-mapped binary benchmark cache
+class benchmark_set {
+private:
+    vector<circuit> circuit_list;
+    vector<logicRam> ram_storage;
+    mapped_file cache_mapping;
+public:
+    benchmark_set(){}
+    benchmark_set(const benchmark_set&) = delete;
+    benchmark_set& operator=(const benchmark_set&) = delete;
+    void clear(){
+        circuit_list.clear();
+        ram_storage.clear();
+        cache_mapping.close_file();
+    }
+    vector<circuit>& get_circuit_list() { return circuit_list; }
+    const vector<circuit>& get_circuit_list() const { return circuit_list; }
+    vector<logicRam>& get_ram_storage() { return ram_storage; }
+    mapped_file& get_cache_mapping() { return cache_mapping; }
+    size_t get_ram_count() const {
+        size_t count = 0;
+        for(auto& circuit: circuit_list){
+            count += circuit.get_ram_list().size();
+        }
+        return count;
+    }
+};
+
+//layout of the binary benchmark cache: header, one record per circuit, then all logicRam records.
+//the stamps of the two text files decide whether the cache still describes them
+const uint32_t BENCHMARK_CACHE_VERSION = 1;
+
+struct source_stamp {
+    uint64_t size;
+    uint64_t mtime_ns;
+    uint64_t checksum;
+};
+
+struct benchmark_cache_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_tag;
+    source_stamp rams_stamp;
+    source_stamp bc_stamp;
+    uint64_t num_circuits;
+    uint64_t num_rams;
+};
+
+struct benchmark_cache_circuit {
+    uint32_t circuit_id;
+    uint32_t num_lb;
+    uint64_t ram_offset;
+    uint64_t ram_count;
+};
+
+bool parse_input(benchmark_set& benchmark, const string& logic_rams_file, const string& logic_bc_file);
+
+bool load_benchmark_cache(benchmark_set& benchmark, const string& cache_file, const string& logic_rams_file,
+        const string& logic_bc_file);
+
+bool write_benchmark_cache(benchmark_set& benchmark, const string& cache_file, const string& logic_rams_file,
+        const string& logic_bc_file);
+
+bool load_benchmark(benchmark_set& benchmark, const string& logic_rams_file, const string& logic_bc_file,
+        const string& cache_file);
+
+//reads the logical ram file one circuit at a time instead of all at once, for -stream: the rams of a circuit
+//have to be on consecutive lines, the file is read through a small buffer ("-" reads stdin) and only the
+//logic block counts are kept for the whole run
+class circuit_stream {
+private:
+    string file_name;
+    string bc_file_name;
+    ifstream file;
+    istream* input;
+    unsigned long line_number;
+    vector<circuit> circuit_list; //every circuit of the logic block count file, without rams
+    vector<bool> streamed; //per circuit, whether its rams were already read
+    bool have_pending; //the first ram of the next circuit, read while looking for the end of the current one
+    unsigned int pending_circuit;
+    logicRam pending_ram;
+    bool read_ram(unsigned int& circuit_number, logicRam& logicram, bool& failed);
+public:
+    circuit_stream(){
+        input = NULL;
+        line_number = 0;
+        have_pending = false;
+        pending_circuit = 0;
+    }
+    bool open(const string& logic_rams_file, const string& logic_bc_file);
+    //appends the rams of the next circuit to ram_list and returns its id and logic block count in
+    //next_circuit; false at the end of the file, with failed set when a line was wrong (reported already)
+    bool read_circuit(circuit& next_circuit, vector<logicRam>& ram_list, bool& failed);
+};
+
+#endif //LAB3_IMPLEMENTATION_INPUT_PARSER_H
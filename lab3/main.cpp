@@ -1,35 +1,191 @@
 
 #include "circuit.h"
+#include "sweep.h"
+#include "input_parser.h"
+#include "output_writer.h"
+#include "report.h"
+#include "verify.h"
+#include "incremental.h"
+#include "server.h"
+#include "score.h"
+#include "stream.h"
+#include "architecture.h"
 
 
-void parse_input(vector<circuit>& logic_circuit_list);
 void debug_print(vector<circuit>& logic_circuit_list, vector<resource>& arc_resource_list);
-void output_mapping(string output_file, vector<circuit>& logic_circuit_list, operationType op);
 void output_my_area(string output_file, vector<circuit>& logic_circuit_list);
+bool extract_option(int& argc, char **argv, string flag, string& value);
+bool extract_flag(int& argc, char **argv, string flag);
+bool write_report(const run_report& report, const string& report_file);
 
 int main(int argc, char **argv) {
 
+    //the command line as given, for the run report
+    string command_line = argv[0];
+    for(int i = 1; i < argc; i++){
+        command_line += string(" ") + argv[i];
+    }
+
+    //optional flags may appear anywhere, they are removed before the positional arguments are checked
+    unsigned int num_threads = default_thread_count();
+    string option_value;
+    if(extract_option(argc, argv, "-t", option_value)){
+        if(atoi(option_value.c_str()) < 1){
+            cout<<"Thread count passed with -t should be a positive number"<<endl;
+            cout<<"Please refer to readme for details"<<endl;
+            return 0;
+        }
+        num_threads = atoi(option_value.c_str());
+    }
+    double refine_budget_ms = 0.0;
+    if(extract_option(argc, argv, "-refine", option_value)){
+        if(atof(option_value.c_str()) <= 0){
+            cout<<"Refinement budget passed with -refine should be a positive number of milliseconds"<<endl;
+            cout<<"Please refer to readme for details"<<endl;
+            return 0;
+        }
+        refine_budget_ms = atof(option_value.c_str());
+    }
+    unsigned int portfolio_size = 1;
+    if(extract_option(argc, argv, "-portfolio", option_value)){
+        if(atoi(option_value.c_str()) < 1){
+            cout<<"Number of orderings passed with -portfolio should be a positive number"<<endl;
+            cout<<"Please refer to readme for details"<<endl;
+            return 0;
+        }
+        portfolio_size = atoi(option_value.c_str());
+    }
+    unsigned int exact_ram_limit = 0;
+    if(extract_option(argc, argv, "-exact", option_value)){
+        if(atoi(option_value.c_str()) < 1){
+            cout<<"Ram count limit passed with -exact should be a positive number"<<endl;
+            cout<<"Please refer to readme for details"<<endl;
+            return 0;
+        }
+        exact_ram_limit = atoi(option_value.c_str());
+    }
+    double exact_time_ms = 1000.0;
+    if(extract_option(argc, argv, "-exact-time", option_value)){
+        if(atof(option_value.c_str()) <= 0){
+            cout<<"Time limit passed with -exact-time should be a positive number of milliseconds"<<endl;
+            cout<<"Please refer to readme for details"<<endl;
+            return 0;
+        }
+        exact_time_ms = atof(option_value.c_str());
+    }
+    string cache_file = "./logical_rams.bin";
+    if(extract_option(argc, argv, "-cache", option_value)){
+        cache_file = option_value == "off" ? "" : option_value;
+    }
+    bool write_text = true;
+    bool write_binary = false;
+    if(extract_option(argc, argv, "-format", option_value)){
+        if(option_value != "text" && option_value != "binary" && option_value != "both"){
+            cout<<"Output format passed with -format should be text, binary or both"<<endl;
+            cout<<"Please refer to readme for details"<<endl;
+            return 0;
+        }
+        write_text = option_value != "binary";
+        write_binary = option_value != "text";
+    }
+    string report_file;
+    extract_option(argc, argv, "-report", report_file);
+    bool verify_mapping = extract_flag(argc, argv, "-verify");
+    bool incremental = extract_flag(argc, argv, "-incremental");
+    if(extract_flag(argc, argv, "-scalar")){
+        set_scoring_kernel(false);
+    }
+    string stream_file;
+    bool streaming = extract_option(argc, argv, "-stream", stream_file);
+    sweep_options sweep_opts;
+    sweep_opts.incremental = incremental;
+    sweep_opts.checkpoint = extract_flag(argc, argv, "-checkpoint");
+    bool sharded = false;
+    if(extract_option(argc, argv, "-shard", option_value)){
+        if(!parse_shard(option_value, sweep_opts.shard_index, sweep_opts.shard_count)){
+            cout<<"Shard passed with -shard should be <index>/<count>, the index from 1 to the count"<<endl;
+            cout<<"Please refer to readme for details"<<endl;
+            return 0;
+        }
+        sharded = true;
+    }
+    if(extract_option(argc, argv, "-processes", option_value)){
+        if(atoi(option_value.c_str()) < 1 || sharded){
+            cout<<"Number of processes passed with -processes should be a positive number, and cannot go with -shard"<<endl;
+            cout<<"Please refer to readme for details"<<endl;
+            return 0;
+        }
+        sweep_opts.shard_count = atoi(option_value.c_str());
+        sweep_opts.fork_shards = sweep_opts.shard_count > 1;
+        sharded = true;
+    }
+    //shards only see each other's results through the checkpoint
+    sweep_opts.checkpoint = sweep_opts.checkpoint || sweep_opts.shard_count > 1;
+
     if(argc < 2){
         cout<<"Cannot run the program due to the lack of arguments"<<endl;
         cout<<"Please refer to readme for details"<<endl;
         return 0;
     }
+    //a stream keeps nothing of the circuits it has written, which these need
+    if(streaming && (atoi(argv[1]) == 5 || atoi(argv[1]) == 6 || incremental || !report_file.empty() || refine_budget_ms > 0 || write_binary)){
+        cout<<"-stream only maps structures 1 to 4 and 7, without -incremental, -report, -refine or a binary mapping file"<<endl;
+        cout<<"Please refer to readme for details"<<endl;
+        return 0;
+    }
+
+    if((sweep_opts.checkpoint || sharded) && atoi(argv[1]) != 5){
+        cout<<"-checkpoint, -shard and -processes only apply to a sweep (structure 5)"<<endl;
+        cout<<"Please refer to readme for details"<<endl;
+        return 0;
+    }
+    //the child processes of -processes keep their figures to themselves
+    if(sweep_opts.fork_shards && !report_file.empty()){
+        cout<<"-report cannot go with -processes, use -t or run the shards with -shard instead"<<endl;
+        cout<<"Please refer to readme for details"<<endl;
+        return 0;
+    }
 
     clock_t cpu_start = clock();
+    run_report report(command_line, num_threads);
+    run_report* report_ptr = report_file.empty() ? NULL : &report;
+    phase_clock phases(report_ptr);
 
-    vector<circuit> logic_circuit_list;
-    //parse the input txt file, store all circuits info in the structure
-    parse_input(logic_circuit_list);
+    benchmark_set benchmark;
+    //a server on stdin/stdout keeps stdout for its answers, everything else goes to stderr
+    bool serve_stdio = atoi(argv[1]) == 6 && argc < 3;
+    streambuf* console = serve_stdio ? cout.rdbuf(cerr.rdbuf()) : cout.rdbuf();
+    //parse the input txt file (or load its binary cache), store all circuits info in the structure
+    if(!streaming && !load_benchmark(benchmark, "./logical_rams.txt", "./logic_block_count.txt", cache_file)){
+        cout<<"Cannot parse the input files, please fix the line reported above"<<endl;
+        return 1;
+    }
+    cout.rdbuf(console);
+    vector<circuit>& logic_circuit_list = benchmark.get_circuit_list();
+    phases.mark("load");
 
-    operationType my_op;
+    operationType my_op = STRATIX_IV;
     int input_arg = atoi(argv[1]);
+    if(input_arg == 5){
+        //map the already parsed circuits against every architecture point of the sweep
+        int sweep_status = run_sweep(argc, argv, logic_circuit_list, num_threads, report_ptr, sweep_opts);
+        if(sweep_status == 0 && report_ptr != NULL && !write_report(report, report_file)){
+            return 1;
+        }
+        clock_t cpu_end = clock();
+        double time_used = (cpu_end - cpu_start) * 1000.0 / CLOCKS_PER_SEC;
+        cout<<"CPU runtime of the program: "<<time_used<<endl;
+        return sweep_status;
+    }
+    if(input_arg == 6){
+        //keep the parsed circuits in memory and answer architecture queries until told to stop
+        return run_server(argc, argv, logic_circuit_list, num_threads);
+    }
     string mapping_outname;
-    unsigned int bram_size, max_width, lb_ratio;
     vector<unsigned int> size_vec;
     vector<unsigned int> mwidth_vec;
     vector<unsigned int> bratio_vec;
     double lutram_ratio = 0.0;
-    vector<unsigned int> ratio_map;
     if(input_arg == 1){
         cout<<"Running program for structure: STRATIX-IV"<<endl;
         my_op = STRATIX_IV;
@@ -64,26 +220,41 @@ int main(int argc, char **argv) {
             cout<<"Please refer to readme for details"<<endl;
             return 0;
         }
+        //every complete <size> <max width> <ratio> group after the lutram ratio adds one more BRAM type
         lutram_ratio = atoi(argv[2]);
-        ratio_map.push_back(atoi(argv[2]));
-        size_vec.push_back(atoi(argv[3]));
-        mwidth_vec.push_back(atoi(argv[4]));
-        bratio_vec.push_back(atoi(argv[5]));
-        ratio_map.push_back(atoi(argv[5]));
-        size_vec.push_back(atoi(argv[6]));
-        mwidth_vec.push_back(atoi(argv[7]));
-        bratio_vec.push_back(atoi(argv[8]));
-        ratio_map.push_back(atoi(argv[8]));
+        for(int arg = 3; arg + 2 < argc; arg += 3){
+            size_vec.push_back(atoi(argv[arg]));
+            mwidth_vec.push_back(atoi(argv[arg + 1]));
+            bratio_vec.push_back(atoi(argv[arg + 2]));
+        }
 
         cout<<"Running program for structure: MB WITH LUTRAM with lutram support ratio: "<<lutram_ratio
-        <<" BRAM size: "<< size_vec[0]<<" with Max Width: "<<mwidth_vec[0]<<" with ratio: "<<bratio_vec[0]
-        <<" and BRAM size: "<< size_vec[1]<<" with Max Width: "<<mwidth_vec[1]<<" with ratio: "<<bratio_vec[1]<<endl;
+        <<" BRAM size: "<< size_vec[0]<<" with Max Width: "<<mwidth_vec[0]<<" with ratio: "<<bratio_vec[0];
+        for(size_t i = 1; i < size_vec.size(); i++){
+            cout<<" and BRAM size: "<< size_vec[i]<<" with Max Width: "<<mwidth_vec[i]<<" with ratio: "<<bratio_vec[i];
+        }
+        cout<<endl;
         my_op = MB_WITH_LUTRAM;
-        mapping_outname = "mapping_MBWITHLUTRAM_" + to_string(int(lutram_ratio))+"_"+
-                to_string(size_vec[0]) + "_" + to_string(mwidth_vec[0]) + "_" +
-                          to_string(bratio_vec[0]) + "_" + to_string(size_vec[1]) + "_" +
-                          to_string(mwidth_vec[1]) + "_" + to_string(bratio_vec[1]) + ".txt";
+        mapping_outname = "mapping_MBWITHLUTRAM_" + to_string(int(lutram_ratio));
+        for(size_t i = 0; i < size_vec.size(); i++){
+            mapping_outname += "_" + to_string(size_vec[i]) + "_" + to_string(mwidth_vec[i]) + "_" +
+                               to_string(bratio_vec[i]);
+        }
+        mapping_outname += ".txt";
 
+    }else if(input_arg == 7){
+        if(argc < 3){
+            cout<<"You need to pass the architecture file"<<endl;
+            cout<<"Please refer to readme for details"<<endl;
+            return 0;
+        }
+        //the mapping file is named after the architecture file, without its directory and extension
+        string arch_name = argv[2];
+        arch_name = arch_name.substr(arch_name.find_last_of('/') + 1);
+        arch_name = arch_name.substr(0, arch_name.find('.'));
+        cout<<"Running program for the architecture described in: "<<argv[2]<<endl;
+        mapping_outname = "mapping_" + arch_name + ".txt";
+        cout<<"my output name would be "<<mapping_outname<<endl;
     }
     else{
         cout<<"Cannot analyze the argument passed in."<<endl;
@@ -91,98 +262,161 @@ int main(int argc, char **argv) {
         return 0;
     }
 
+    //a zero ratio would divide by zero when a candidate is priced, like the sweep and the server refuse it here
+    for(size_t i = 0; i < size_vec.size(); i++){
+        if(bratio_vec[i] == 0 || mwidth_vec[i] == 0 || size_vec[i] < mwidth_vec[i]){
+            cout<<"Ratios and widths should be positive and no BRAM can be narrower than one bit deep"<<endl;
+            cout<<"Please refer to readme for details"<<endl;
+            return 0;
+        }
+    }
+    if(input_arg == 4 && lutram_ratio == 0){
+        cout<<"The lutram support ratio should be positive"<<endl;
+        cout<<"Please refer to readme for details"<<endl;
+        return 0;
+    }
+
     //prepare physical ram resource for the type of architecture that input specified
     vector<resource> arc_resource_list;
-    construct_resource(arc_resource_list, my_op, input_parameter(size_vec, mwidth_vec, bratio_vec, lutram_ratio));
+    area_model arc_area_model;
+    if(input_arg == 7){
+        if(!load_architecture(argv[2], arc_resource_list, arc_area_model)){
+            cout<<"Cannot read the architecture file, please fix the line reported above"<<endl;
+            return 1;
+        }
+        cout<<"Architecture resources:";
+        for(auto& physical_ram: arc_resource_list){
+            cout<<" "<<physical_ram.get_label()<<" (type "<<physical_ram.get_output_type()<<")";
+        }
+        cout<<endl;
+    }else{
+        construct_resource(arc_resource_list, arc_area_model, my_op,
+                           input_parameter(size_vec, mwidth_vec, bratio_vec, lutram_ratio));
+    }
+    phases.mark("resources");
 
 //    debug_print(logic_circuit_list, arc_resource_list);
 
     //perform the actual mapping
-    if(my_op == STRATIX_IV){
-        perform_basic_core_mapper(logic_circuit_list, arc_resource_list);
+    mapper_options options;
+    options.num_threads = num_threads;
+    options.refine_budget_ms = refine_budget_ms;
+    options.portfolio_size = portfolio_size;
+    options.exact_ram_limit = exact_ram_limit;
+    options.exact_time_ms = exact_time_ms;
+    if(streaming){
+        //circuits are read, mapped and written a window at a time, the benchmark set is never loaded as a whole
+        if(!map_stream(stream_file, "./logic_block_count.txt", arc_resource_list, arc_area_model, options,
+                       mapping_outname, verify_mapping)){
+            return 1;
+        }
+        clock_t cpu_end = clock();
+        double time_used = (cpu_end - cpu_start) * 1000.0 / CLOCKS_PER_SEC;
+        cout<<"CPU runtime of the program: "<<time_used<<endl;
+        return 0;
+    }
+    if(report_ptr != NULL){
+        report.add_point(mapping_outname, arc_resource_list, logic_circuit_list.size());
+        options.report = report_ptr;
+    }
+    //incremental runs keep the results of the previous run next to the mapping file
+    string state_outname = mapping_outname.substr(0, mapping_outname.size() - 4) + ".state";
+    vector<uint64_t> fingerprint_list;
+    mapping_arena arena; //owns the mapped rams of every circuit until the output is written
+    if(incremental){
+        perform_incremental_mapper(logic_circuit_list, arc_resource_list, arc_area_model, options, arena, state_outname,
+                                   fingerprint_list);
     }else{
-        perform_custom_core_mapper(logic_circuit_list, arc_resource_list, my_op, ratio_map);
+        perform_core_mapper(logic_circuit_list, arc_resource_list, arc_area_model, options, arena);
     }
 
     //for debug purpose, check two structures
 //    debug_print(logic_circuit_list, arc_resource_list);
 
-    //output the mapping file
-    output_mapping(mapping_outname, logic_circuit_list, my_op);
+    //check every mapping in memory the way the checker would, before anything is written
+    if(verify_mapping){
+        vector<double> checked_area_list(logic_circuit_list.size(), 0.0);
+        for(size_t i = 0; i < logic_circuit_list.size(); i++){
+            const circuit& circuit = logic_circuit_list[i];
+            if(circuit.get_ram_list().empty()){
+                continue;
+            }
+            string error;
+            if(!verify_circuit_mapping(circuit, circuit.get_mapped_list(), arc_resource_list, arc_area_model,
+                                       checked_area_list[i], error)){
+                cout<<"Illegal mapping: "<<error<<endl;
+                cout<<"Something went wrong"<<endl;
+                return 1;
+            }
+            cout<<"circuit: "<<circuit.get_circuit_id()<<" checked area is: "<<checked_area_list[i]<<endl;
+        }
+        cout<<"All mappings are legal, geometric mean area is: "
+            <<geometric_mean_area(logic_circuit_list, checked_area_list)<<endl;
+        phases.mark("verify");
+    }
+
+    //output the mapping file, and/or its binary form with the same name ending in .bin
+    if(write_text && !write_mapping_text(mapping_outname, logic_circuit_list, num_threads)){
+        cout<<"Cannot write the mapping file "<<mapping_outname<<endl;
+        return 1;
+    }
+    string binary_outname = mapping_outname.substr(0, mapping_outname.size() - 4) + ".bin";
+    if(write_binary && !write_mapping_binary(binary_outname, logic_circuit_list)){
+        cout<<"Cannot write the binary mapping file "<<binary_outname<<endl;
+        return 1;
+    }
+    if(incremental && !write_mapping_state(state_outname, architecture_fingerprint(arc_resource_list, arc_area_model, options),
+                                           logic_circuit_list, fingerprint_list)){
+        cout<<"Cannot write the mapping state "<<state_outname<<", the next run will map every circuit"<<endl;
+    }
+    phases.mark("output");
+    if(report_ptr != NULL && !write_report(report, report_file)){
+        return 1;
+    }
 
     clock_t cpu_end = clock();
-    double time_used = (cpu_end - cpu_start) / (CLOCKS_PER_SEC/1000);
+    double time_used = (cpu_end - cpu_start) * 1000.0 / CLOCKS_PER_SEC;
     cout<<"CPU runtime of the program: "<<time_used<<endl;
 
     return 0;
 }
 
-void parse_input(vector<circuit>& logic_circuit_list){
-    //---------------------parsing the txt file---------------
-    string logic_rams_file = "./logical_rams.txt";
-    string logic_bc_file = "./logic_block_count.txt";
-    ifstream rams_fs(logic_rams_file);
-    ifstream bc_fs(logic_bc_file);
-
-    //get rid of the header line
-    string header_line;
-    getline(rams_fs, header_line);
-    getline(rams_fs, header_line);
-    getline(bc_fs, header_line);
-
-    unsigned int bc_id, bc_num;
-    while (bc_fs >> bc_id >> bc_num) {
-        vector<logicRam> empty_list;
-        vector<mappedRam> empty_mapped_list;
-        circuit curr_circuit = circuit(bc_id, bc_num, empty_list, empty_mapped_list);
-        logic_circuit_list.push_back(curr_circuit);
-    }
-
-    string lram_mode,circuit_number, lram_id, lram_d, lram_w;
-    while (rams_fs >> circuit_number >> lram_id >> lram_mode >> lram_d >> lram_w) {
-        ramMode actual_mode;
-        if (lram_mode == "SimpleDualPort") {
-            actual_mode = SimpleDualPort;
-        } else if (lram_mode == "ROM") {
-            actual_mode = ROM;
-        } else if (lram_mode == "SinglePort") {
-            actual_mode = SinglePort;
-        } else {
-            actual_mode = TrueDualPort;
-        }
-        unsigned int int_circuit_number = stoi(circuit_number);
-        unsigned int int_lram_id = stoi(lram_id);
-        unsigned int int_lram_d = stoi(lram_d);
-        unsigned int int_lram_w = stoi(lram_w);
-
-        logicRam curr_lr = logicRam(int_lram_id, actual_mode, int_lram_d, int_lram_w);
-        logic_circuit_list[int_circuit_number].add_logic_ram(curr_lr);
+bool extract_option(int& argc, char **argv, string flag, string& value){
+    //look for "<flag> <value>", take it out of argv and shift the remaining arguments down
+    for(int i = 1; i < argc - 1; i++){
+        if(flag == argv[i]){
+            value = argv[i + 1];
+            for(int j = i; j + 2 < argc; j++){
+                argv[j] = argv[j + 2];
+            }
+            argc -= 2;
+            return true;
+        }
     }
+    return false;
 }
 
-void output_mapping(string output_file, vector<circuit>& logic_circuit_list, operationType op){
-    ofstream outs;
-    outs.open(output_file);
-    for(auto& circuit: logic_circuit_list){
-        int circuit_id = circuit.get_circuit_id();
-        for(auto& mapped: circuit.get_mapped_list()){
-            //need to adjust type printed
-            if(mapped.get_map_type() == BRAM_CUSTOM){
-                if(op == NO_LUTRAM){
-                    mapped.change_type(LUTRAM); //get type = 1
-                }else{
-                    mapped.change_type(BRAM_8192); //get type = 2
-                }
-            }else if(mapped.get_map_type() == BRAM_CUSTOM_2){
-                mapped.change_type(BRAM_128K); //get type = 3
+bool extract_flag(int& argc, char **argv, string flag){
+    //same as extract_option for a flag that takes no value
+    for(int i = 1; i < argc; i++){
+        if(flag == argv[i]){
+            for(int j = i; j + 1 < argc; j++){
+                argv[j] = argv[j + 1];
             }
-            outs<<circuit_id<<" "<<mapped.get_ram_id()<<" "<<mapped.get_lut()<<" LW "<<mapped.get_lwidth()<<" LD "
-            <<mapped.get_ldepth()<<" ID "<<mapped.get_mapper_id()<<" S "<<mapped.get_s()<<" P "<<mapped.get_p()
-            <<" Type "<<mapped.get_map_type()<<" Mode "<<mapped.get_lram_mode()<<" W "<<mapped.get_pwidth()
-            <<" D "<<mapped.get_pdepth()<<"\n";
+            argc -= 1;
+            return true;
         }
     }
-    outs.close();
+    return false;
+}
+
+bool write_report(const run_report& report, const string& report_file){
+    if(!report.write_json(report_file)){
+        cout<<"Cannot write the run report "<<report_file<<endl;
+        return false;
+    }
+    cout<<"Run report written to "<<report_file<<endl;
+    return true;
 }
 
 void output_my_area(string output_file, vector<circuit>& logic_circuit_list){
@@ -216,14 +450,14 @@ void debug_print(vector<circuit>& logic_circuit_list, vector<resource>& arc_reso
 //    std::cout << "print the circuit 59, RAM id = 604, width: " << (logic_circuit_list[59].get_ram_list())[604].get_lram_depth() <<std::endl;
 
     cout <<"Check resource list:"<<endl;
-    for(int i = 0; i < arc_resource_list.size(); i++){
+    for(size_t i = 0; i < arc_resource_list.size(); i++){
         cout<<"---------"<<i<<"----------"<<endl;
         cout<<"Resource "<< i << " has type as: " <<arc_resource_list[i].get_pram_type()<< endl;
         cout<<"it has ratio: "<<arc_resource_list[i].get_ratio()<<endl;
         cout<<"it max depth: "<<arc_resource_list[i].get_max_depth()<<", max width: "<<arc_resource_list[i].get_max_width()
             <<" and size is: "<<arc_resource_list[i].get_pram_size()<<endl;
-        vector<pair<unsigned int, unsigned int> > test_comb = arc_resource_list[i].get_comb_list();
-        for(int j = 0; j < test_comb.size(); j++){
+        const vector<pair<unsigned int, unsigned int> >& test_comb = arc_resource_list[i].get_comb_list();
+        for(size_t j = 0; j < test_comb.size(); j++){
             cout<<"combination: {"<<test_comb[j].first<<", "<<test_comb[j].second<<"}"<<endl;
         }
     }
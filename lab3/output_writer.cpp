@@ -0,0 +1,173 @@
+#include "output_writer.h"
+#include <fcntl.h>
+#include <cerrno>
+#include <unistd.h>
+
+bool output_buffer::open_file(const string& file_name){
+    close_file();
+    fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    failed = fd < 0;
+    data.reserve(FLUSH_SIZE + 4096);
+    return !failed;
+}
+
+bool output_buffer::flush(){
+    const char* pos = data.data();
+    size_t left = data.size();
+    while(fd >= 0 && left > 0){
+        ssize_t written = write(fd, pos, left);
+        if(written < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            failed = true;
+            break;
+        }
+        pos += written;
+        left -= written;
+    }
+    data.clear();
+    return !failed;
+}
+
+bool output_buffer::close_file(){
+    if(fd >= 0){
+        flush();
+        if(close(fd) != 0){
+            failed = true;
+        }
+        fd = -1;
+    }
+    return !failed;
+}
+
+void output_buffer::append_uint(uint64_t value){
+    //two digits per division, written backwards into a small scratch area
+    static const char digit_pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    char scratch[20];
+    char* pos = scratch + sizeof(scratch);
+    while(value >= 100){
+        unsigned int pair = (unsigned int)(value % 100) * 2;
+        value /= 100;
+        *--pos = digit_pairs[pair + 1];
+        *--pos = digit_pairs[pair];
+    }
+    if(value >= 10){
+        unsigned int pair = (unsigned int)value * 2;
+        *--pos = digit_pairs[pair + 1];
+        *--pos = digit_pairs[pair];
+    }else{
+        *--pos = (char)('0' + value);
+    }
+    append_text(pos, scratch + sizeof(scratch) - pos);
+}
+
+//one line per mapped ram, same fields and spelling the checker reads
+void format_circuit_mapping(const circuit& mapped_circuit, output_buffer& outs){
+    unsigned int circuit_id = mapped_circuit.get_circuit_id();
+    for(auto& mapped: mapped_circuit.get_mapped_list()){
+        outs.append_uint(circuit_id);
+        outs.append_text(" ", 1);
+        outs.append_uint(mapped.get_ram_id());
+        outs.append_text(" ", 1);
+        outs.append_uint(mapped.get_lut());
+        outs.append_text(" LW ", 4);
+        outs.append_uint(mapped.get_lwidth());
+        outs.append_text(" LD ", 4);
+        outs.append_uint(mapped.get_ldepth());
+        outs.append_text(" ID ", 4);
+        outs.append_uint(mapped.get_mapper_id());
+        outs.append_text(" S ", 3);
+        outs.append_uint(mapped.get_s());
+        outs.append_text(" P ", 3);
+        outs.append_uint(mapped.get_p());
+        outs.append_text(" Type ", 6);
+        outs.append_uint(mapped.get_map_type());
+        outs.append_text(" Mode ", 6);
+        outs.append_text(ram_mode_name(mapped.get_lram_mode()));
+        outs.append_text(" W ", 3);
+        outs.append_uint(mapped.get_pwidth());
+        outs.append_text(" D ", 3);
+        outs.append_uint(mapped.get_pdepth());
+        outs.append_text("\n", 1);
+    }
+}
+
+bool write_mapping_text(const string& output_file, const vector<circuit>& logic_circuit_list, unsigned int num_threads){
+    output_buffer outs;
+    if(!outs.open_file(output_file)){
+        return false;
+    }
+    if(num_threads <= 1){
+        for(auto& circuit: logic_circuit_list){
+            format_circuit_mapping(circuit, outs);
+        }
+        return outs.close_file();
+    }
+
+    //circuits are formatted into their own chunks in parallel and written in circuit order; a window of
+    //circuits is handled at a time so only about WINDOW_RAMS formatted lines are held in memory
+    const size_t WINDOW_RAMS = 1 << 18;
+    size_t window_begin = 0;
+    while(window_begin < logic_circuit_list.size()){
+        size_t window_end = window_begin;
+        size_t window_rams = 0;
+        while(window_end < logic_circuit_list.size() && (window_end == window_begin ||
+              window_rams + logic_circuit_list[window_end].get_mapped_list().size() <= WINDOW_RAMS)){
+            window_rams += logic_circuit_list[window_end].get_mapped_list().size();
+            window_end++;
+        }
+        vector<output_buffer> chunk_list(window_end - window_begin);
+        vector<size_t> job_order(chunk_list.size());
+        for(size_t i = 0; i < job_order.size(); i++){
+            job_order[i] = i;
+        }
+        run_parallel_jobs(job_order, num_threads, [&](size_t i){
+            format_circuit_mapping(logic_circuit_list[window_begin + i], chunk_list[i]);
+        });
+        for(auto& chunk: chunk_list){
+            outs.append_text(chunk.get_data().data(), chunk.get_data().size());
+        }
+        window_begin = window_end;
+    }
+    return outs.close_file();
+}
+
+bool write_mapping_binary(const string& output_file, const vector<circuit>& logic_circuit_list){
+    output_buffer outs;
+    if(!outs.open_file(output_file)){
+        return false;
+    }
+    mapping_binary_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "LAB3MAPB", sizeof(header.magic));
+    header.version = MAPPING_BINARY_VERSION;
+    header.endian_tag = 0x01020304;
+    for(auto& circuit: logic_circuit_list){
+        header.num_records += circuit.get_mapped_list().size();
+    }
+    outs.append_raw(&header, sizeof(header));
+    for(auto& circuit: logic_circuit_list){
+        for(auto& mapped: circuit.get_mapped_list()){
+            mapping_binary_record record;
+            record.circuit_id = circuit.get_circuit_id();
+            record.ram_id = mapped.get_ram_id();
+            record.additional_lut = mapped.get_lut();
+            record.logic_width = mapped.get_lwidth();
+            record.logic_depth = mapped.get_ldepth();
+            record.mapper_id = mapped.get_mapper_id();
+            record.parallel = mapped.get_p();
+            record.mapped_width = mapped.get_pwidth();
+            record.mapped_depth = mapped.get_pdepth();
+            record.serial = (uint8_t)mapped.get_s();
+            record.type = (uint8_t)mapped.get_map_type();
+            record.lram_mode = (uint8_t)mapped.get_lram_mode();
+            record.reserved = 0;
+            outs.append_raw(&record, sizeof(record));
+        }
+    }
+    return outs.close_file();
+}
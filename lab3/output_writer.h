@@ -0,0 +1,78 @@
+#ifndef LAB3_IMPLEMENTATION_OUTPUT_WRITER_H
+#define LAB3_IMPLEMENTATION_OUTPUT_WRITER_H
+
+#include "circuit.h"
+#include <cstring>
+
+//text or raw bytes collected in one growing buffer; numbers are formatted by hand instead of through iostreams.
+//with an open file the buffer is written out whenever it grows past FLUSH_SIZE, without one it just keeps growing
+//(used for the per-circuit chunks that are formatted in parallel)
+class output_buffer {
+private:
+    string data;
+    int fd;
+    bool failed;
+    static const size_t FLUSH_SIZE = 1 << 20;
+    void flush_if_full(){
+        if(fd >= 0 && data.size() >= FLUSH_SIZE){
+            flush();
+        }
+    }
+public:
+    output_buffer(){
+        fd = -1;
+        failed = false;
+    }
+    ~output_buffer(){ close_file(); }
+    output_buffer(const output_buffer&) = delete;
+    output_buffer& operator=(const output_buffer&) = delete;
+    bool open_file(const string& file_name);
+    //flush what is left and close, false if any write failed
+    bool close_file();
+    bool flush();
+    void append_text(const char* text, size_t length){
+        data.append(text, length);
+        flush_if_full();
+    }
+    void append_text(const char* text){ append_text(text, strlen(text)); }
+    void append_raw(const void* bytes, size_t length){ append_text((const char*)bytes, length); }
+    void append_uint(uint64_t value);
+    const string& get_data() const { return data; }
+};
+
+//compact binary mapping file: header followed by one fixed-size record per mapped RAM, in the same order
+//as the text mapping file (circuit by circuit, ram by ram), all fields little endian on the usual hosts
+const uint32_t MAPPING_BINARY_VERSION = 1;
+
+struct mapping_binary_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_tag;
+    uint64_t num_records;
+};
+
+struct mapping_binary_record {
+    uint32_t circuit_id;
+    uint32_t ram_id;
+    uint32_t additional_lut;
+    uint32_t logic_width;
+    uint32_t logic_depth;
+    uint32_t mapper_id;
+    uint32_t parallel;
+    uint32_t mapped_width;
+    uint32_t mapped_depth;
+    uint8_t serial;
+    uint8_t type;
+    uint8_t lram_mode; //ramMode value
+    uint8_t reserved;
+};
+
+static_assert(sizeof(mapping_binary_record) == 40, "mapping_binary_record is a fixed on-disk layout");
+
+void format_circuit_mapping(const circuit& mapped_circuit, output_buffer& outs);
+
+bool write_mapping_text(const string& output_file, const vector<circuit>& logic_circuit_list, unsigned int num_threads);
+
+bool write_mapping_binary(const string& output_file, const vector<circuit>& logic_circuit_list);
+
+#endif //LAB3_IMPLEMENTATION_OUTPUT_WRITER_H
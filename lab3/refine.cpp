@@ -0,0 +1,200 @@
+#include "refine.h"
+#include <random>
+
+unsigned int mapping_counters::required_LB(int* binding) const {
+    //lutram blocks are logic blocks too, and only one in every <share> logic blocks can be one
+    unsigned int LBrequired = logic_LB;
+    for(size_t b = 0; b < used_blocks.size(); b++){
+        LBrequired += model->get_lutram_block(b) * used_blocks[b];
+    }
+    int binding_resource = -1;
+    for(size_t b = 0; b < used_blocks.size(); b++){
+        unsigned int resource_LB = model->get_lutram_block(b) ?
+                (unsigned int)ceil(used_blocks[b] * model->get_lutram_share(b)) :
+                used_blocks[b] * model->get_block_ratio(b);
+        if(resource_LB > LBrequired){
+            LBrequired = resource_LB;
+            binding_resource = b;
+        }
+    }
+    if(binding != NULL){
+        *binding = binding_resource;
+    }
+    return LBrequired;
+}
+
+double mapping_counters::area() const {
+    return model->area_for_LB(required_LB());
+}
+
+double mapping_area(const circuit& circuit, const area_model& model, const mapping_result& result){
+    mapping_counters counters(model, circuit.get_circuit_num_lb());
+    for(auto chosen: result.choice_list){
+        counters.add(*chosen);
+    }
+    return counters.area();
+}
+
+string rewrite_mapping(const circuit& circuit, const vector<resource>& resource_list, const area_model& model,
+        const vector<const map_candidate*>& choice_list, double area, mapping_result& result){
+    //a mapper id is the shape's first id plus the candidate's offset within the shape
+    const_span<logicRam> logic_ram_list = circuit.get_ram_list();
+    vector<unsigned int> used_blocks(resource_list.size(), 0);
+    //logic, extra LUT and lutram blocks of the rams so far, as map_circuit counts them
+    unsigned int logic_LB = circuit.get_circuit_num_lb();
+    for(size_t i = 0; i < logic_ram_list.size(); i++){
+        const map_candidate* chosen = choice_list[i];
+        unsigned int num_blocks = chosen->serial * chosen->parallel;
+        if(chosen != result.choice_list[i]){
+            const mappedRam& seed = result.mapped_list[i];
+            const logicRam& logicram = logic_ram_list[i];
+            unsigned int shape_base_id = seed.get_mapper_id() - result.choice_list[i]->id_offset;
+            double cost = model.area_if_added(logic_LB, chosen->resource_index, used_blocks[chosen->resource_index],
+                                              num_blocks, chosen->extra_LB);
+            result.mapped_list[i] = mappedRam(logicram.get_lram_id(), shape_base_id + chosen->id_offset, chosen->num_luts,
+                    logicram.get_lram_depth(), logicram.get_lram_width(), chosen->serial, chosen->parallel,
+                    resource_list[chosen->resource_index].get_output_type(), logicram.get_lram_mode(), chosen->depth,
+                    chosen->width, cost);
+            result.choice_list[i] = chosen;
+        }
+        used_blocks[chosen->resource_index] += num_blocks;
+        logic_LB += chosen->extra_LB + model.get_lutram_block(chosen->resource_index) * num_blocks;
+    }
+    result.area = area;
+    ostringstream usage;
+    for(size_t b = 0; b < resource_list.size(); b++){
+        usage<<(b == 0 ? "" : ", ")<<resource_list[b].get_label()<<": "<<used_blocks[b];
+    }
+    return usage.str();
+}
+
+//circuits are refined one per job, so the shape lookups are done once per circuit
+struct refine_state {
+    vector<const map_candidate*> shape_first;
+    vector<uint32_t> shape_size;
+    double seed_area;
+    double floor_area;
+    bool has_alternative; //some ram has more than one candidate to move between
+};
+
+static void prepare_refine_state(const circuit& circuit, const area_model& model, const candidate_cache& cache,
+        const mapping_result& result, refine_state& state){
+    const_span<logicRam> logic_ram_list = circuit.get_ram_list();
+    size_t num_rams = logic_ram_list.size();
+    mapping_counters counters(model, circuit.get_circuit_num_lb());
+    //no mapping can do better than the circuit's own logic plus the fewest extra LUT blocks of every ram
+    mapping_counters floor_counters(model, circuit.get_circuit_num_lb());
+    state.shape_first.resize(num_rams);
+    state.shape_size.resize(num_rams);
+    state.has_alternative = false;
+    for(size_t i = 0; i < num_rams; i++){
+        uint32_t shape = 0;
+        cache.find_shape(logic_ram_list[i], shape);
+        state.shape_first[i] = cache.shape_begin(shape);
+        state.shape_size[i] = cache.shape_end(shape) - cache.shape_begin(shape);
+        state.has_alternative = state.has_alternative || state.shape_size[i] > 1;
+        unsigned int fewest_extra_LB = state.shape_first[i]->extra_LB;
+        for(uint32_t c = 1; c < state.shape_size[i]; c++){
+            fewest_extra_LB = min(fewest_extra_LB, state.shape_first[i][c].extra_LB);
+        }
+        floor_counters.add_logic_LB(fewest_extra_LB);
+        counters.add(*result.choice_list[i]);
+    }
+    state.seed_area = counters.area();
+    state.floor_area = floor_counters.area();
+}
+
+static void anneal_circuit(const circuit& circuit, const vector<resource>& resource_list, const area_model& model,
+        const refine_state& state, mapping_result& result, chrono::steady_clock::time_point deadline){
+    const_span<logicRam> logic_ram_list = circuit.get_ram_list();
+    size_t num_rams = logic_ram_list.size();
+    const vector<const map_candidate*>& shape_first = state.shape_first;
+    const vector<uint32_t>& shape_size = state.shape_size;
+    mapping_counters counters(model, circuit.get_circuit_num_lb());
+    vector<const map_candidate*> choice_list(result.choice_list.begin(), result.choice_list.end());
+    for(auto chosen: choice_list){
+        counters.add(*chosen);
+    }
+    double seed_area = state.seed_area;
+    double current_area = seed_area;
+
+    //simulated annealing: a move that grows the area by delta is still taken with probability exp(-delta/T),
+    //the temperature falls from start_temperature to ~0 as the deadline approaches, and the best assignment
+    //seen so far is kept aside because the current one may be worse
+    mt19937 generator(circuit.get_circuit_id() + 1);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    auto start = chrono::steady_clock::now();
+    double budget = chrono::duration<double>(deadline - start).count();
+    double start_temperature = 0.01 * seed_area;
+    double temperature = start_temperature;
+    double best_area = seed_area;
+    vector<const map_candidate*> best_list = choice_list;
+    for(size_t move = 0; ; move++){
+        if((move & 255) == 0){
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if(elapsed >= budget){
+                break;
+            }
+            temperature = start_temperature * pow(0.0001, elapsed / budget);
+        }
+        size_t i = generator() % num_rams;
+        if(shape_size[i] < 2){
+            continue;
+        }
+        const map_candidate* proposal = shape_first[i] + generator() % shape_size[i];
+        if(proposal == choice_list[i]){
+            continue;
+        }
+        counters.remove(*choice_list[i]);
+        counters.add(*proposal);
+        double proposal_area = counters.area();
+        if(proposal_area <= current_area || unit(generator) < exp((current_area - proposal_area) / temperature)){
+            current_area = proposal_area;
+            choice_list[i] = proposal;
+            if(current_area < best_area){
+                best_area = current_area;
+                best_list = choice_list;
+            }
+        }else{
+            counters.remove(*proposal);
+            counters.add(*choice_list[i]);
+        }
+    }
+    current_area = best_area;
+    choice_list = best_list;
+    if(current_area >= seed_area){
+        return;
+    }
+
+    string usage = rewrite_mapping(circuit, resource_list, model, choice_list, current_area, result);
+    ostringstream circuit_log;
+    circuit_log<<"circuit: "<<circuit.get_circuit_id()<<" refined to "<<usage<<", refined area is: "<<current_area
+               <<" (greedy seed: "<<seed_area<<")"<<endl;
+    result.summary += circuit_log.str();
+}
+
+void refine_circuits(const vector<circuit>& logic_circuit_list, const vector<resource>& resource_list,
+        const area_model& model, const candidate_cache& cache, vector<mapping_result>& result_list,
+        unsigned int num_threads, chrono::steady_clock::time_point deadline){
+    //circuits already at their floor area are left alone, the others share what is left of the budget
+    vector<refine_state> state_list(logic_circuit_list.size());
+    vector<size_t> job_order;
+    for(size_t i : largest_circuit_first(logic_circuit_list)){
+        prepare_refine_state(logic_circuit_list[i], model, cache, result_list[i], state_list[i]);
+        if(!result_list[i].proven_optimal && state_list[i].has_alternative &&
+           state_list[i].seed_area > state_list[i].floor_area){
+            job_order.push_back(i);
+        }
+    }
+    atomic<size_t> jobs_left(job_order.size());
+    run_parallel_jobs(job_order, num_threads, [&](size_t i){
+        size_t waiting_jobs = jobs_left--;
+        auto now = chrono::steady_clock::now();
+        if(now >= deadline){
+            return;
+        }
+        size_t sharing = min<size_t>(num_threads, waiting_jobs);
+        auto circuit_deadline = now + (deadline - now) * sharing / waiting_jobs;
+        anneal_circuit(logic_circuit_list[i], resource_list, model, state_list[i], result_list[i], circuit_deadline);
+    });
+}
@@ -0,0 +1,57 @@
+#ifndef LAB3_IMPLEMENTATION_REFINE_H
+#define LAB3_IMPLEMENTATION_REFINE_H
+
+#include "circuit.h"
+
+//block counters of one complete mapping of a circuit, priced the way the checker prices it: the logic blocks
+//must hold the logic and LUTRAM, give enough LUTRAM-capable blocks and match every BRAM type's ratio.
+//re-pricing after a change only walks the few resource rows, so a move is evaluated in constant time
+class mapping_counters {
+private:
+    const area_model* model;
+    unsigned int logic_LB; //logic blocks of the circuit plus the ones added for extra LUTs
+    vector<unsigned int> used_blocks; //per resource, lutram blocks included
+public:
+    mapping_counters(const area_model& i_model, unsigned int i_num_lb){
+        model = &i_model;
+        logic_LB = i_num_lb;
+        used_blocks.assign(i_model.get_resource_count(), 0);
+    }
+    void add(const map_candidate& candidate){
+        logic_LB += candidate.extra_LB;
+        used_blocks[candidate.resource_index] += candidate.serial * candidate.parallel;
+    }
+    void add_logic_LB(unsigned int extra_LB){
+        logic_LB += extra_LB;
+    }
+    void remove_logic_LB(unsigned int extra_LB){
+        logic_LB -= extra_LB;
+    }
+    void remove(const map_candidate& candidate){
+        logic_LB -= candidate.extra_LB;
+        used_blocks[candidate.resource_index] -= candidate.serial * candidate.parallel;
+    }
+    //binding, if given, is set to the resource whose blocks set the logic block count, -1 when it is the logic
+    unsigned int required_LB(int* binding = NULL) const;
+    double area() const;
+    unsigned int get_used_blocks(size_t r) const { return used_blocks[r]; }
+};
+
+//area of a complete mapping of a circuit, priced with mapping_counters
+double mapping_area(const circuit& circuit, const area_model& model, const mapping_result& result);
+
+//replace the mapping of a circuit by another choice of cached candidates (one per ram, in input order) whose
+//area is already known; returns "<label>: <blocks>, ..." of the new mapping for the console summary. a rewritten
+//ram gets the cost the greedy would have given it, the area once it is added to the rams before it
+string rewrite_mapping(const circuit& circuit, const vector<resource>& resource_list, const area_model& model,
+        const vector<const map_candidate*>& choice_list, double area, mapping_result& result);
+
+//simulated annealing over the greedy results, one move re-maps one logical RAM to another cached candidate of
+//its shape. every circuit that is not already at its floor area gets an equal share of the time left before
+//the deadline, and a result is only rewritten when the best area found is strictly below its greedy seed
+//(both priced with mapping_counters). circuits the exact search proved optimal are skipped
+void refine_circuits(const vector<circuit>& logic_circuit_list, const vector<resource>& resource_list,
+        const area_model& model, const candidate_cache& cache, vector<mapping_result>& result_list, unsigned int num_threads,
+        chrono::steady_clock::time_point deadline);
+
+#endif //LAB3_IMPLEMENTATION_REFINE_H
@@ -0,0 +1,155 @@
+#include "report.h"
+#include <iomanip>
+
+static string json_string(const string& text){
+    string quoted = "\"";
+    for(char c: text){
+        if(c == '"' || c == '\\'){
+            quoted += '\\';
+            quoted += c;
+        }else if((unsigned char)c < 0x20){
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+            quoted += escaped;
+        }else{
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+point_report& run_report::add_point(const string& name, const vector<resource>& resource_list, size_t num_circuits){
+    point_list.push_back(point_report());
+    point_report& point = point_list.back();
+    point.name = name;
+    for(auto& physical_ram: resource_list){
+        point.resource_labels.push_back(physical_ram.get_label());
+    }
+    point.circuit_list.resize(num_circuits);
+    return point;
+}
+
+void fill_circuit_report(const circuit& circuit, const area_model& model, const candidate_cache& cache,
+        const_span<const map_candidate*> choice_list, unsigned int greedy_passes, uint64_t skipped_by_bound,
+        circuit_report& report){
+    report.mapped = true;
+    report.circuit_id = circuit.get_circuit_id();
+    report.num_rams = circuit.get_ram_list().size();
+    report.candidates_evaluated = 0;
+    report.pruned_deep = 0;
+    report.pruned_tdp = 0;
+    report.pruned_dominated = 0;
+    for(auto& logicram: circuit.get_ram_list()){
+        uint32_t shape = 0;
+        if(cache.find_shape(logicram, shape)){
+            report.candidates_evaluated += cache.shape_end(shape) - cache.shape_begin(shape);
+            report.pruned_deep += cache.get_pruned_deep(shape);
+            report.pruned_tdp += cache.get_pruned_tdp(shape);
+            report.pruned_dominated += cache.get_pruned_dominated(shape);
+        }
+    }
+    report.candidates_evaluated = report.candidates_evaluated * greedy_passes - skipped_by_bound;
+    report.skipped_by_bound = skipped_by_bound;
+    mapping_counters counters(model, circuit.get_circuit_num_lb());
+    for(auto chosen: choice_list){
+        counters.add(*chosen);
+    }
+    report.used_blocks.resize(model.get_resource_count());
+    for(size_t r = 0; r < report.used_blocks.size(); r++){
+        report.used_blocks[r] = counters.get_used_blocks(r);
+    }
+    report.required_LB = counters.required_LB(&report.binding_resource);
+    report.area = model.area_for_LB(report.required_LB);
+}
+
+void fill_kept_circuit_report(const circuit& circuit, const vector<resource>& resource_list, const area_model& model,
+        const mappedRam* mapped_begin, size_t mapped_count, circuit_report& report){
+    report = circuit_report();
+    report.mapped = true;
+    report.kept = true;
+    report.circuit_id = circuit.get_circuit_id();
+    report.num_rams = circuit.get_ram_list().size();
+    //the stored rows only have the Type written to the mapping file, which names the resource
+    mapping_counters counters(model, circuit.get_circuit_num_lb());
+    for(const mappedRam* mapped = mapped_begin; mapped != mapped_begin + mapped_count; mapped++){
+        map_candidate priced;
+        priced.resource_index = 0;
+        while(priced.resource_index + 1 < resource_list.size() &&
+              resource_list[priced.resource_index].get_output_type() != mapped->get_map_type()){
+            priced.resource_index++;
+        }
+        priced.serial = mapped->get_s();
+        priced.parallel = mapped->get_p();
+        priced.extra_LB = (mapped->get_lut() + 9) / 10;
+        counters.add(priced);
+    }
+    report.used_blocks.resize(model.get_resource_count());
+    for(size_t r = 0; r < report.used_blocks.size(); r++){
+        report.used_blocks[r] = counters.get_used_blocks(r);
+    }
+    report.required_LB = counters.required_LB(&report.binding_resource);
+    report.area = model.area_for_LB(report.required_LB);
+    report.greedy_area = report.area;
+}
+
+bool run_report::write_json(const string& file) const {
+    ofstream outs(file);
+    if(!outs){
+        return false;
+    }
+    outs<<fixed<<setprecision(3);
+    outs<<"{\n  \"command\": "<<json_string(command)<<",\n  \"threads\": "<<num_threads<<",\n  \"phases_ms\": {";
+    for(size_t i = 0; i < phase_list.size(); i++){
+        outs<<(i == 0 ? "\n    " : ",\n    ")<<json_string(phase_list[i].first)<<": "<<phase_list[i].second;
+    }
+    outs<<"\n  },\n  \"points\": [";
+    for(size_t p = 0; p < point_list.size(); p++){
+        const point_report& point = point_list[p];
+        //totals and the geometric mean skip circuits without logic rams, which are never mapped
+        uint64_t candidates_evaluated = 0, skipped_by_bound = 0, pruned_deep = 0, pruned_tdp = 0, pruned_dominated = 0;
+        double log_sum = 0.0;
+        unsigned int counted = 0;
+        for(auto& report: point.circuit_list){
+            if(!report.mapped){
+                continue;
+            }
+            candidates_evaluated += report.candidates_evaluated;
+            skipped_by_bound += report.skipped_by_bound;
+            pruned_dominated += report.pruned_dominated;
+            pruned_deep += report.pruned_deep;
+            pruned_tdp += report.pruned_tdp;
+            if(report.num_rams > 0 && report.area > 0){
+                log_sum += log(report.area);
+                counted++;
+            }
+        }
+        outs<<(p == 0 ? "\n    {" : ",\n    {")<<"\n      \"name\": "<<json_string(point.name)
+            <<",\n      \"geomean_area\": "<<(counted == 0 ? 0.0 : exp(log_sum / counted))
+            <<",\n      \"candidates_evaluated\": "<<candidates_evaluated<<",\n      \"skipped_by_bound\": "<<skipped_by_bound
+            <<",\n      \"pruned_deep\": "<<pruned_deep<<",\n      \"pruned_tdp\": "<<pruned_tdp
+            <<",\n      \"pruned_dominated\": "<<pruned_dominated<<",\n      \"circuits\": [";
+        bool first_circuit = true;
+        for(auto& report: point.circuit_list){
+            if(!report.mapped){
+                continue;
+            }
+            outs<<(first_circuit ? "\n        {" : ",\n        {")<<"\"id\": "<<report.circuit_id<<", \"rams\": "<<report.num_rams
+                <<", \"candidates_evaluated\": "<<report.candidates_evaluated<<", \"skipped_by_bound\": "
+                <<report.skipped_by_bound<<", \"pruned_deep\": "<<report.pruned_deep<<", \"pruned_tdp\": "<<report.pruned_tdp
+                <<", \"pruned_dominated\": "<<report.pruned_dominated<<", \"used\": {";
+            for(size_t r = 0; r < report.used_blocks.size(); r++){
+                outs<<(r == 0 ? "" : ", ")<<json_string(point.resource_labels[r])<<": "<<report.used_blocks[r];
+            }
+            string binding = report.binding_resource < 0 ? "logic" : point.resource_labels[report.binding_resource];
+            outs<<"}, \"required_LB\": "<<report.required_LB<<", \"binding\": "<<json_string(binding)
+                <<", \"greedy_area\": "<<report.greedy_area<<", \"area\": "<<report.area
+                <<", \"proven_optimal\": "<<(report.proven_optimal ? "true" : "false")
+                <<", \"kept\": "<<(report.kept ? "true" : "false")<<"}";
+            first_circuit = false;
+        }
+        outs<<"\n      ]\n    }";
+    }
+    outs<<"\n  ]\n}\n";
+    outs.close();
+    return !outs.fail();
+}
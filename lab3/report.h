@@ -0,0 +1,87 @@
+#ifndef LAB3_IMPLEMENTATION_REPORT_H
+#define LAB3_IMPLEMENTATION_REPORT_H
+
+#include "refine.h"
+
+//figures of the final mapping of one circuit; blocks and areas are counted the way the checker counts them
+struct circuit_report {
+    unsigned int circuit_id = 0;
+    size_t num_rams = 0;
+    uint64_t candidates_evaluated = 0; //cached candidates priced by the greedy passes over all rams
+    uint64_t skipped_by_bound = 0; //cached candidates the greedy passes skipped with the bound of their resource
+    uint64_t pruned_dominated = 0; //candidates never cached because an earlier one of their resource is never worse
+    uint64_t pruned_deep = 0; //configurations never cached because they need more than 16 in series
+    uint64_t pruned_tdp = 0; //configurations never cached because TDP cannot use them
+    vector<unsigned int> used_blocks; //per resource, lutram blocks included
+    unsigned int required_LB = 0;
+    int binding_resource = -1; //resource whose blocks set required_LB, -1 when the logic and lutram do
+    double greedy_area = 0.0; //area of the greedy mapping before the exact search and refinement, priced like area
+    double area = 0.0;
+    bool proven_optimal = false;
+    bool kept = false; //an incremental run took the mapping from its previous run, nothing was evaluated for it
+    bool mapped = false; //false when the run has no figures of the circuit (a sweep pair taken from the state or
+                         //the checkpoint, or left to another shard), which is then not reported
+};
+
+//one architecture mapped in the run: the single one of ./mapping 1-4, or one point of a sweep
+struct point_report {
+    string name;
+    vector<string> resource_labels;
+    vector<circuit_report> circuit_list; //in circuit order
+};
+
+//opt-in record of one run, written as JSON at the end; nothing is collected when no report was asked for,
+//the mapper only checks for a NULL pointer once per stage
+class run_report {
+private:
+    string command;
+    unsigned int num_threads;
+    vector<pair<string, double> > phase_list; //wall-clock milliseconds, in the order the phases ran
+    vector<point_report> point_list;
+public:
+    run_report(const string& i_command, unsigned int i_threads){
+        command = i_command;
+        num_threads = i_threads;
+    }
+    void add_phase(const string& name, double ms){ phase_list.push_back(make_pair(name, ms)); }
+    point_report& add_point(const string& name, const vector<resource>& resource_list, size_t num_circuits);
+    point_report& last_point(){ return point_list.back(); }
+    point_report& get_point(size_t p){ return point_list[p]; }
+    bool write_json(const string& file) const;
+};
+
+//adds the wall time since the previous mark as a phase of the report, does nothing without a report
+class phase_clock {
+private:
+    run_report* report;
+    chrono::steady_clock::time_point last;
+public:
+    phase_clock(run_report* i_report){
+        report = i_report;
+        if(report != NULL){
+            last = chrono::steady_clock::now();
+        }
+    }
+    void mark(const string& name){
+        if(report == NULL){
+            return;
+        }
+        auto now = chrono::steady_clock::now();
+        report->add_phase(name, chrono::duration<double, milli>(now - last).count());
+        last = now;
+    }
+};
+
+//fill the report of one circuit from its chosen candidates (one per ram, any order); greedy_passes is the number
+//of times the greedy went over every ram, the portfolio size, and skipped_by_bound what all passes skipped.
+//greedy_area (priced with mapping_area, like area) and proven_optimal are left to the caller
+void fill_circuit_report(const circuit& circuit, const area_model& model, const candidate_cache& cache,
+        const_span<const map_candidate*> choice_list, unsigned int greedy_passes, uint64_t skipped_by_bound,
+        circuit_report& report);
+
+//fill the report of a circuit an incremental run kept, from its stored mapped rams; the blocks and both areas
+//are counted like fill_circuit_report counts them, the candidate figures stay 0
+void fill_kept_circuit_report(const circuit& circuit, const vector<resource>& resource_list, const area_model& model,
+        const mappedRam* mapped_begin, size_t mapped_count, circuit_report& report);
+
+#endif //LAB3_IMPLEMENTATION_REPORT_H
@@ -0,0 +1,153 @@
+#include "fixed_layout.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LAB3_AVX2_KERNEL
+#endif
+
+uint32_t score_ram_scalar(const ram_scoring& ram, uint32_t& best_LB){
+    uint32_t best = 0;
+    best_LB = candidate_LB(ram, 0);
+    for(uint32_t i = 1; i < ram.count; i++){
+        uint32_t LB = candidate_LB(ram, i);
+        if(LB < best_LB){
+            best_LB = LB;
+            best = i;
+        }
+    }
+    return best;
+}
+
+#ifdef LAB3_AVX2_KERNEL
+__attribute__((target("avx2")))
+static inline uint32_t lanes_min(__m256i lanes){
+    __m256i folded = _mm256_min_epu32(lanes, _mm256_permute2x128_si256(lanes, lanes, 1));
+    folded = _mm256_min_epu32(folded, _mm256_shuffle_epi32(folded, _MM_SHUFFLE(1, 0, 3, 2)));
+    folded = _mm256_min_epu32(folded, _mm256_shuffle_epi32(folded, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(folded));
+}
+
+//the resource constants of a layout in one register each: loaded from the tables for the generic layout, the
+//layout's own values otherwise (constants, apart from the ratio of a single BRAM)
+template <typename layout>
+static inline uint32_t table_entry(const ram_scoring& ram, bool lutram, uint32_t r){
+    if(r >= layout::num_resources){
+        return 0;
+    }
+    return lutram ? layout::lutram_block(ram, r) : layout::block_ratio(ram, r);
+}
+
+template <typename layout>
+__attribute__((target("avx2")))
+static inline __m256i resource_register(const ram_scoring& ram, bool lutram, __m256i table_mask){
+    if(layout::num_resources == 0){
+        return _mm256_maskload_epi32((const int*)(lutram ? ram.lutram_block : ram.block_ratio), table_mask);
+    }
+    return _mm256_setr_epi32(table_entry<layout>(ram, lutram, 0), table_entry<layout>(ram, lutram, 1),
+            table_entry<layout>(ram, lutram, 2), table_entry<layout>(ram, lutram, 3), table_entry<layout>(ram, lutram, 4),
+            table_entry<layout>(ram, lutram, 5), table_entry<layout>(ram, lutram, 6), table_entry<layout>(ram, lutram, 7));
+}
+
+//8 candidates per step, the resource constants of every lane are looked up in registers by its resource index
+//(a layout with a single resource broadcasts them and never reads the resource column). a lane past the end of
+//the ram is masked off (never loaded, LB set to the largest value), every lane keeps the first candidate of its
+//own with the fewest logic blocks, and the lanes are merged by (logic blocks, position), so the result is the
+//scalar loop's
+template <typename layout>
+__attribute__((target("avx2")))
+static uint32_t score_ram_avx2(const ram_scoring& ram, uint32_t& best_LB){
+    static_assert(layout::num_resources <= SIMD_SCORING_RESOURCES, "a fixed layout has to fit the AVX2 registers");
+    if(layout::num_resources == 0 && ram.num_resources > SIMD_SCORING_RESOURCES){
+        return score_ram_scalar(ram, best_LB);
+    }
+    uint32_t num_resources = layout::num_resources == 0 ? ram.num_resources : layout::num_resources;
+    __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i all_ones = _mm256_set1_epi32(-1);
+    __m256i table_mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(num_resources), lane);
+    __m256i lutram_table = resource_register<layout>(ram, true, table_mask);
+    __m256i ratio_table = resource_register<layout>(ram, false, table_mask);
+    __m256i used_table = _mm256_maskload_epi32((const int*)ram.used_blocks, table_mask);
+    __m256i logic_LB = _mm256_set1_epi32(ram.logic_LB);
+    __m256i lane_best = all_ones;
+    __m256i lane_position = lane;
+    for(uint32_t i = 0; i < ram.count; i += 8){
+        __m256i valid = _mm256_cmpgt_epi32(_mm256_set1_epi32(ram.count - i), lane);
+        __m256i blocks = _mm256_maskload_epi32((const int*)(ram.blocks + i), valid);
+        __m256i extra_LB = _mm256_maskload_epi32((const int*)(ram.extra_LB + i), valid);
+        __m256i lutram_block = lutram_table;
+        __m256i block_ratio = ratio_table;
+        __m256i used_blocks = used_table;
+        if(layout::num_resources != 1){
+            __m256i resource = _mm256_maskload_epi32((const int*)(ram.resource + i), valid);
+            lutram_block = _mm256_permutevar8x32_epi32(lutram_table, resource);
+            block_ratio = _mm256_permutevar8x32_epi32(ratio_table, resource);
+            used_blocks = _mm256_permutevar8x32_epi32(used_table, resource);
+        }else{
+            lutram_block = _mm256_broadcastd_epi32(_mm256_castsi256_si128(lutram_table));
+            block_ratio = _mm256_broadcastd_epi32(_mm256_castsi256_si128(ratio_table));
+            used_blocks = _mm256_broadcastd_epi32(_mm256_castsi256_si128(used_table));
+        }
+        __m256i LBrequired = _mm256_add_epi32(_mm256_add_epi32(logic_LB, extra_LB), _mm256_mullo_epi32(lutram_block, blocks));
+        __m256i bram_LB = _mm256_mullo_epi32(_mm256_add_epi32(used_blocks, blocks), block_ratio);
+        __m256i LB = _mm256_or_si256(_mm256_max_epu32(LBrequired, bram_LB), _mm256_andnot_si256(valid, all_ones));
+        //lanes where the new LB is smaller take the new candidate, the others keep theirs
+        __m256i smaller = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_min_epu32(LB, lane_best), lane_best), valid);
+        if(i == 0){
+            smaller = valid;
+        }
+        lane_position = _mm256_blendv_epi8(lane_position, _mm256_add_epi32(lane, _mm256_set1_epi32(i)), smaller);
+        lane_best = _mm256_blendv_epi8(lane_best, LB, smaller);
+    }
+    best_LB = lanes_min(lane_best);
+    //the smallest position among the lanes holding the fewest logic blocks
+    __m256i tied = _mm256_cmpeq_epi32(lane_best, _mm256_set1_epi32(best_LB));
+    return lanes_min(_mm256_or_si256(lane_position, _mm256_andnot_si256(tied, all_ones)));
+}
+#endif
+
+ram_scoring_kernel avx2_scoring_kernel(){
+#ifdef LAB3_AVX2_KERNEL
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        return score_ram_avx2<generic_layout>;
+    }
+#endif
+    return NULL;
+}
+
+template <typename layout>
+uint32_t score_ram_simd(const ram_scoring& ram, uint32_t& best_LB){
+#ifdef LAB3_AVX2_KERNEL
+    return score_ram_avx2<layout>(ram, best_LB);
+#else
+    return score_ram_layout<layout>(ram, best_LB);
+#endif
+}
+
+template uint32_t score_ram_simd<generic_layout>(const ram_scoring& ram, uint32_t& best_LB);
+template uint32_t score_ram_simd<stratix_iv_layout>(const ram_scoring& ram, uint32_t& best_LB);
+template uint32_t score_ram_simd<single_bram_layout<false> >(const ram_scoring& ram, uint32_t& best_LB);
+template uint32_t score_ram_simd<single_bram_layout<true> >(const ram_scoring& ram, uint32_t& best_LB);
+
+ram_scoring_kernel select_scoring_kernel(bool allow_simd){
+    ram_scoring_kernel simd_kernel = avx2_scoring_kernel();
+    return allow_simd && simd_kernel != NULL ? simd_kernel : score_ram_scalar;
+}
+
+const char* scoring_kernel_name(ram_scoring_kernel kernel){
+    return kernel == score_ram_scalar ? "scalar" : "avx2";
+}
+
+static ram_scoring_kernel active_kernel = select_scoring_kernel(true);
+
+void set_scoring_kernel(bool allow_simd){
+    active_kernel = select_scoring_kernel(allow_simd);
+}
+
+ram_scoring_kernel get_scoring_kernel(){
+    return active_kernel;
+}
+
+bool simd_scoring_enabled(){
+    return active_kernel != score_ram_scalar;
+}
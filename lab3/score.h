@@ -0,0 +1,56 @@
+#ifndef LAB3_IMPLEMENTATION_SCORE_H
+#define LAB3_IMPLEMENTATION_SCORE_H
+
+#include "circuit.h"
+
+//the greedy's candidate scoring for one logical ram: every cached candidate of its shape, on every resource, in
+//one array. the area only grows with the logic blocks required (area_model::area_for_LB), so the cheapest
+//candidate is the first one needing the fewest logic blocks and the kernel only works on integers:
+//LB = max(logic_LB + extra_LB + lutram_block[r] * blocks, (used_blocks[r] + blocks) * block_ratio[r]) for the
+//candidate's resource r, with the same 32-bit unsigned arithmetic as area_model::LB_if_added
+struct ram_scoring {
+    const uint32_t* blocks; //serial * parallel of every candidate of the shape
+    const uint32_t* extra_LB;
+    const uint32_t* resource; //resource index of every candidate
+    uint32_t count; //at least 1
+    uint32_t logic_LB;
+    //per resource, num_resources entries each
+    const uint32_t* lutram_block;
+    const uint32_t* block_ratio;
+    const uint32_t* used_blocks;
+    uint32_t num_resources;
+};
+
+//the AVX2 kernel keeps the per-resource tables in one register each, so it covers up to 8 resources
+const uint32_t SIMD_SCORING_RESOURCES = 8;
+
+//position of the first candidate with the fewest required logic blocks, which go to best_LB
+typedef uint32_t (*ram_scoring_kernel)(const ram_scoring& ram, uint32_t& best_LB);
+
+//logic blocks required with blocks more blocks of resource r and extra_LB more LUT blocks
+inline uint32_t resource_LB(const ram_scoring& ram, uint32_t r, uint32_t blocks, uint32_t extra_LB){
+    uint32_t LBrequired = ram.logic_LB + extra_LB + ram.lutram_block[r] * blocks;
+    uint32_t bram_LB = (ram.used_blocks[r] + blocks) * ram.block_ratio[r];
+    return LBrequired > bram_LB ? LBrequired : bram_LB;
+}
+
+inline uint32_t candidate_LB(const ram_scoring& ram, uint32_t i){
+    return resource_LB(ram, ram.resource[i], ram.blocks[i], ram.extra_LB[i]);
+}
+
+//the plain loop; strictly smaller only, so ties keep the earlier candidate like the greedy always did
+uint32_t score_ram_scalar(const ram_scoring& ram, uint32_t& best_LB);
+
+//the AVX2 kernel when the CPU has it and it is allowed, the scalar loop otherwise; both pick the same candidate.
+//NULL when the AVX2 kernel is not built in or the CPU lacks AVX2
+ram_scoring_kernel select_scoring_kernel(bool allow_simd);
+ram_scoring_kernel avx2_scoring_kernel();
+const char* scoring_kernel_name(ram_scoring_kernel kernel);
+
+//kernel used by map_circuit, chosen once at startup; -scalar turns the AVX2 kernel off
+void set_scoring_kernel(bool allow_simd);
+ram_scoring_kernel get_scoring_kernel();
+//whether the kernel in use is the AVX2 one; map_circuit calls the layout's own kernel (fixed_layout.h) by it
+bool simd_scoring_enabled();
+
+#endif //LAB3_IMPLEMENTATION_SCORE_H
@@ -0,0 +1,377 @@
+#include "server.h"
+#include "verify.h"
+#include <iomanip>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <signal.h>
+#include <atomic>
+#include <list>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static bool parse_number(const string& token, unsigned int& value){
+    if(token.empty() || token.size() > 9 || token.find_first_not_of("0123456789") != string::npos){
+        return false;
+    }
+    value = atoi(token.c_str());
+    return true;
+}
+
+shared_ptr<const candidate_cache> geometry_cache_pool::get_cache(const vector<resource>& resource_list){
+    string geometry = resource_geometry_key(resource_list);
+    promise<shared_ptr<const candidate_cache> > building;
+    shared_future<shared_ptr<const candidate_cache> > cached;
+    bool builder = false;
+    {
+        lock_guard<mutex> lock(pool_mutex);
+        auto found = cache_by_geometry.find(geometry);
+        if(found != cache_by_geometry.end()){
+            cached = found->second;
+        }else{
+            builder = true;
+            cached = building.get_future().share();
+            cache_by_geometry[geometry] = cached;
+            geometry_order.push_back(geometry);
+            if(geometry_order.size() > MAX_CACHED_GEOMETRIES){
+                cache_by_geometry.erase(geometry_order.front());
+                geometry_order.pop_front();
+            }
+        }
+    }
+    //the cache is built outside the lock, so queries of other geometries are not held up
+    if(builder){
+        shared_ptr<candidate_cache> cache = make_shared<candidate_cache>();
+        cache->add_circuits(resource_list, *logic_circuit_list);
+        building.set_value(cache);
+    }
+    return cached.get();
+}
+
+string answer_query(const string& query, const vector<circuit>& logic_circuit_list, geometry_cache_pool& caches,
+        unsigned int num_threads){
+    stringstream query_stream(query);
+    vector<unsigned int> value_list;
+    string token;
+    while(query_stream>>token){
+        unsigned int value;
+        if(!parse_number(token, value)){
+            return "error cannot analyze the argument: " + token;
+        }
+        value_list.push_back(value);
+    }
+    if(value_list.empty()){
+        return "error empty query";
+    }
+    //same structures and argument order as ./mapping 1-4, checked like the points of a sweep
+    operationType op;
+    vector<unsigned int> size_vec, mwidth_vec, bratio_vec;
+    double lutram_ratio = 0.0;
+    size_t first_group = 1;
+    if(value_list[0] == 1 && value_list.size() == 1){
+        op = STRATIX_IV;
+    }else if((value_list[0] == 2 || value_list[0] == 3) && value_list.size() == 4){
+        op = value_list[0] == 2 ? NO_LUTRAM : WITH_LUTRAM;
+    }else if(value_list[0] == 4 && value_list.size() >= 5 && (value_list.size() - 2) % 3 == 0){
+        op = MB_WITH_LUTRAM;
+        lutram_ratio = value_list[1];
+        first_group = 2;
+        if(lutram_ratio == 0){
+            return "error the lutram support ratio should be positive";
+        }
+    }else{
+        return "error expected 1, 2|3 <size> <max width> <ratio> or 4 <lutram ratio> <size> <max width> <ratio> [...]";
+    }
+    if(op != STRATIX_IV){
+        for(size_t i = first_group; i + 2 < value_list.size(); i += 3){
+            size_vec.push_back(value_list[i]);
+            mwidth_vec.push_back(value_list[i + 1]);
+            bratio_vec.push_back(value_list[i + 2]);
+            if(value_list[i + 1] == 0 || value_list[i + 2] == 0 || value_list[i] < value_list[i + 1]){
+                return "error ratios and widths should be positive and no BRAM can be narrower than one bit deep";
+            }
+        }
+    }
+
+    vector<resource> resource_list;
+    area_model model;
+    construct_resource(resource_list, model, op, input_parameter(size_vec, mwidth_vec, bratio_vec, lutram_ratio));
+    shared_ptr<const candidate_cache> cache = caches.get_cache(resource_list);
+    vector<double> area_list(logic_circuit_list.size(), 0.0);
+    vector<string> error_list(logic_circuit_list.size());
+    run_parallel_jobs(largest_circuit_first(logic_circuit_list), num_threads, [&](size_t i){
+        if(logic_circuit_list[i].get_ram_list().empty()){
+            return;
+        }
+        static thread_local mapping_arena scratch;
+        size_t num_rams = logic_circuit_list[i].get_ram_list().size();
+        scratch.reserve_rows(num_rams);
+        mapping_result result;
+        scratch.bind(result, 0, num_rams);
+        map_circuit(logic_circuit_list[i], resource_list, model, *cache, result);
+        verify_circuit_mapping(logic_circuit_list[i], result.mapped_list, resource_list, model, area_list[i],
+                               error_list[i]);
+    });
+    for(auto& error: error_list){
+        if(!error.empty()){
+            return "error illegal mapping, " + error;
+        }
+    }
+    ostringstream answer;
+    answer<<fixed<<setprecision(2)<<"ok "<<geometric_mean_area(logic_circuit_list, area_list);
+    for(auto area: area_list){
+        answer<<" "<<area;
+    }
+    return answer.str();
+}
+
+static bool send_line(int fd, const string& line){
+    string data = line + "\n";
+    size_t sent = 0;
+    while(sent < data.size()){
+        ssize_t count = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if(count < 0 && errno == EINTR){
+            continue;
+        }
+        if(count <= 0){
+            return false;
+        }
+        sent += count;
+    }
+    return true;
+}
+
+//a socket server stops on SIGTERM, SIGINT or a "quit" line of any client: the flag is raised and the listening
+//socket shut down, which wakes the accept loop (shutdown is async-signal-safe, so the signal handler can do it)
+static atomic<bool> stop_requested(false);
+static atomic<int> stop_listen_fd(-1);
+
+static void request_stop(){
+    stop_requested = true;
+    int listen_fd = stop_listen_fd;
+    if(listen_fd >= 0){
+        shutdown(listen_fd, SHUT_RDWR);
+    }
+}
+
+static void handle_stop_signal(int){
+    request_stop();
+}
+
+//the mapping workers of a socket server: connections hand their queries over and wait for the answer, so at most
+//num_threads queries are mapped at once however many clients are connected
+class query_pool {
+private:
+    const vector<circuit>* logic_circuit_list;
+    geometry_cache_pool* caches;
+    mutex queue_mutex;
+    condition_variable queue_ready;
+    deque<pair<string, promise<string>*> > query_queue;
+    bool stopping = false;
+public:
+    query_pool(const vector<circuit>& i_circuit_list, geometry_cache_pool& i_caches){
+        logic_circuit_list = &i_circuit_list;
+        caches = &i_caches;
+    }
+    string answer(const string& query){
+        promise<string> answered;
+        future<string> result = answered.get_future();
+        {
+            lock_guard<mutex> lock(queue_mutex);
+            if(stopping){
+                return "error the server is shutting down";
+            }
+            query_queue.push_back(make_pair(query, &answered));
+        }
+        queue_ready.notify_one();
+        return result.get();
+    }
+    //a worker maps one query at a time with a single thread, the workers together are the pool. once the pool
+    //stops, a worker finishes the query it is mapping and returns
+    void work(){
+        while(true){
+            unique_lock<mutex> lock(queue_mutex);
+            queue_ready.wait(lock, [&](){ return stopping || !query_queue.empty(); });
+            if(stopping){
+                return;
+            }
+            pair<string, promise<string>*> next = query_queue.front();
+            query_queue.pop_front();
+            lock.unlock();
+            next.second->set_value(answer_query(next.first, *logic_circuit_list, *caches, 1));
+        }
+    }
+    //queries still waiting for a worker are refused, the workers return after their current query
+    void stop(){
+        lock_guard<mutex> lock(queue_mutex);
+        stopping = true;
+        for(auto& waiting: query_queue){
+            waiting.second->set_value("error the server is shutting down");
+        }
+        query_queue.clear();
+        queue_ready.notify_all();
+    }
+};
+
+//answer the query lines of one client in order until it hangs up; "quit" stops the whole server
+static void serve_connection(int fd, query_pool& pool){
+    string pending;
+    char chunk[4096];
+    while(true){
+        size_t line_end;
+        while((line_end = pending.find('\n')) != string::npos){
+            string query = pending.substr(0, line_end);
+            pending.erase(0, line_end + 1);
+            if(!query.empty() && query.back() == '\r'){
+                query.pop_back();
+            }
+            if(query == "quit"){
+                request_stop();
+                return;
+            }
+            if(query.find_first_not_of(" \t") != string::npos &&
+               !send_line(fd, pool.answer(query))){
+                return;
+            }
+        }
+        ssize_t count = read(fd, chunk, sizeof(chunk));
+        if(count < 0 && errno == EINTR){
+            continue;
+        }
+        if(count <= 0){
+            return;
+        }
+        pending.append(chunk, count);
+    }
+}
+
+//the connection threads of a socket server; a finished one closes its socket and is joined by the accept loop,
+//at shutdown the open sockets are shut down so every reader returns and all threads are joined
+class connection_list {
+private:
+    struct connection {
+        int fd;
+        bool done;
+        thread reader;
+    };
+    mutex list_mutex;
+    list<connection> connections;
+public:
+    void start(int fd, query_pool& pool){
+        lock_guard<mutex> lock(list_mutex);
+        connections.push_back(connection());
+        connection& added = connections.back();
+        added.fd = fd;
+        added.done = false;
+        added.reader = thread([this, &added, &pool](){
+            serve_connection(added.fd, pool);
+            lock_guard<mutex> lock(list_mutex);
+            close(added.fd);
+            added.done = true;
+        });
+    }
+    void join_finished(){
+        lock_guard<mutex> lock(list_mutex);
+        for(auto c = connections.begin(); c != connections.end(); ){
+            if(c->done){
+                c->reader.join();
+                c = connections.erase(c);
+            }else{
+                c++;
+            }
+        }
+    }
+    void stop_all(){
+        {
+            lock_guard<mutex> lock(list_mutex);
+            for(auto& c: connections){
+                if(!c.done){
+                    shutdown(c.fd, SHUT_RDWR);
+                }
+            }
+        }
+        for(auto& c: connections){
+            c.reader.join();
+        }
+        connections.clear();
+    }
+};
+
+int run_server(int argc, char **argv, const vector<circuit>& logic_circuit_list, unsigned int num_threads){
+    geometry_cache_pool caches(logic_circuit_list);
+    if(argc < 3){
+        cerr<<"Serving "<<logic_circuit_list.size()<<" circuits on stdin/stdout, one query per line"<<endl;
+        string query;
+        while(getline(cin, query)){
+            if(!query.empty() && query.back() == '\r'){
+                query.pop_back();
+            }
+            if(query == "quit"){
+                break;
+            }
+            if(query.find_first_not_of(" \t") != string::npos){
+                cout<<answer_query(query, logic_circuit_list, caches, num_threads)<<endl;
+            }
+        }
+        return 0;
+    }
+
+    string socket_path = argv[2];
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(socket_path.size() >= sizeof(address.sun_path)){
+        cout<<"Socket path "<<socket_path<<" is too long"<<endl;
+        return 1;
+    }
+    strcpy(address.sun_path, socket_path.c_str());
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path.c_str());
+    if(listen_fd < 0 || ::bind(listen_fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(listen_fd, 64) != 0){
+        cout<<"Cannot listen on "<<socket_path<<": "<<strerror(errno)<<endl;
+        return 1;
+    }
+    stop_listen_fd = listen_fd;
+    struct sigaction stop_action;
+    memset(&stop_action, 0, sizeof(stop_action));
+    stop_action.sa_handler = handle_stop_signal;
+    sigemptyset(&stop_action.sa_mask);
+    sigaction(SIGTERM, &stop_action, NULL);
+    sigaction(SIGINT, &stop_action, NULL);
+    cout<<"Serving "<<logic_circuit_list.size()<<" circuits on "<<socket_path<<" with "<<num_threads<<" workers"<<endl;
+    query_pool pool(logic_circuit_list, caches);
+    vector<thread> workers;
+    for(unsigned int i = 0; i < num_threads; i++){
+        workers.push_back(thread([&](){ pool.work(); }));
+    }
+    //every connection gets a thread that only reads its queries and writes the answers
+    connection_list connections;
+    int status = 0;
+    while(!stop_requested){
+        int fd = accept(listen_fd, NULL, NULL);
+        if(fd < 0){
+            if(stop_requested){
+                break;
+            }
+            if(errno == EINTR || errno == ECONNABORTED){
+                continue;
+            }
+            cout<<"Cannot accept a connection: "<<strerror(errno)<<endl;
+            status = 1;
+            break;
+        }
+        connections.join_finished();
+        connections.start(fd, pool);
+    }
+    stop_listen_fd = -1;
+    close(listen_fd);
+    unlink(socket_path.c_str());
+    //the queries being mapped are finished and answered, then every worker and connection thread is joined
+    pool.stop();
+    for(auto& w: workers){
+        w.join();
+    }
+    connections.stop_all();
+    cout<<"Server on "<<socket_path<<" stopped"<<endl;
+    return status;
+}
@@ -0,0 +1,44 @@
+#ifndef LAB3_IMPLEMENTATION_SERVER_H
+#define LAB3_IMPLEMENTATION_SERVER_H
+
+#include "circuit.h"
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <map>
+#include <deque>
+
+//the candidate caches of the architectures queried so far, one per BRAM geometry as the points of a sweep share
+//them (see resource_geometry_key). every query and connection uses the same pool: the first query of a geometry
+//builds its cache, queries arriving meanwhile wait for it, and later ones, whatever their ratios, only map.
+//past MAX_CACHED_GEOMETRIES the oldest geometry is dropped, queries still using it keep their reference
+const size_t MAX_CACHED_GEOMETRIES = 64;
+
+class geometry_cache_pool {
+private:
+    const vector<circuit>* logic_circuit_list;
+    mutex pool_mutex;
+    map<string, shared_future<shared_ptr<const candidate_cache> > > cache_by_geometry;
+    deque<string> geometry_order; //oldest first
+public:
+    geometry_cache_pool(const vector<circuit>& i_circuit_list){
+        logic_circuit_list = &i_circuit_list;
+    }
+    shared_ptr<const candidate_cache> get_cache(const vector<resource>& resource_list);
+};
+
+//answer one query line: the arguments of a ./mapping 1-4 run ("1", "2 8192 32 10", "4 3 8192 32 10 131072 128 300").
+//the circuits are greedy mapped with num_threads threads and checked like -verify does; the answer is one line,
+//"ok <geometric mean area> <area of circuit 0> <area of circuit 1> ..." or "error <reason>"
+string answer_query(const string& query, const vector<circuit>& logic_circuit_list, geometry_cache_pool& caches,
+        unsigned int num_threads);
+
+//./mapping 6 answers query lines from stdin on stdout until "quit" or the end of the input, mapping the circuits
+//of each query with num_threads threads. ./mapping 6 <socket path> listens on a UNIX domain socket instead: every
+//connection has a thread of its own that reads its queries and hands them to a pool of num_threads workers, so
+//any number of clients can stay connected and up to num_threads queries are mapped at the same time. the socket
+//server runs until SIGTERM, SIGINT or a "quit" line of a client, and returns once all its threads are joined
+int run_server(int argc, char **argv, const vector<circuit>& logic_circuit_list, unsigned int num_threads);
+
+#endif //LAB3_IMPLEMENTATION_SERVER_H
@@ -0,0 +1,83 @@
+#include "stream.h"
+#include "input_parser.h"
+#include "output_writer.h"
+#include "verify.h"
+
+bool map_stream(const string& logic_rams_file, const string& logic_bc_file, const vector<resource>& resource_list,
+        const area_model& model, const mapper_options& options, const string& mapping_outname, bool verify_mapping){
+    circuit_stream input;
+    if(!input.open(logic_rams_file, logic_bc_file)){
+        return false;
+    }
+    output_buffer outs;
+    if(!outs.open_file(mapping_outname)){
+        cout<<"Cannot write the mapping file "<<mapping_outname<<endl;
+        return false;
+    }
+    //the window's rams, circuits and the first ram of every circuit; all of them only ever grow to the
+    //largest window, like the arena that holds the window's mapped rams
+    vector<logicRam> window_rams;
+    vector<circuit> window;
+    vector<size_t> window_first;
+    mapping_arena arena;
+    size_t num_circuits = 0;
+    size_t num_rams = 0;
+    double log_sum = 0.0;
+    unsigned int counted = 0;
+    bool at_end = false;
+    while(!at_end){
+        circuit next_circuit(0, 0);
+        size_t first = window_rams.size();
+        bool failed;
+        if(input.read_circuit(next_circuit, window_rams, failed)){
+            window.push_back(next_circuit);
+            window_first.push_back(first);
+        }else if(failed){
+            cout<<"Cannot parse the input files, please fix the line reported above"<<endl;
+            return false;
+        }else{
+            at_end = true;
+        }
+        if(window.empty() || (!at_end && window_rams.size() < STREAM_WINDOW_RAMS)){
+            continue;
+        }
+        //the window's rams are all read, so they no longer move
+        for(size_t i = 0; i < window.size(); i++){
+            size_t last = i + 1 < window.size() ? window_first[i + 1] : window_rams.size();
+            window[i].set_ram_list(window_rams.data() + window_first[i], last - window_first[i]);
+        }
+        perform_core_mapper(window, resource_list, model, options, arena);
+        for(auto& circuit: window){
+            if(verify_mapping){
+                double area;
+                string error;
+                if(!verify_circuit_mapping(circuit, circuit.get_mapped_list(), resource_list, model, area, error)){
+                    cout<<"Illegal mapping: "<<error<<endl;
+                    cout<<"Something went wrong"<<endl;
+                    return false;
+                }
+                cout<<"circuit: "<<circuit.get_circuit_id()<<" checked area is: "<<area<<endl;
+                if(area > 0){
+                    log_sum += log(area);
+                    counted++;
+                }
+            }
+            format_circuit_mapping(circuit, outs);
+            num_rams += circuit.get_ram_list().size();
+        }
+        num_circuits += window.size();
+        window.clear();
+        window_rams.clear();
+        window_first.clear();
+    }
+    if(!outs.close_file()){
+        cout<<"Cannot write the mapping file "<<mapping_outname<<endl;
+        return false;
+    }
+    if(verify_mapping){
+        cout<<"All mappings are legal, geometric mean area is: "<<(counted == 0 ? 0.0 : exp(log_sum / counted))<<endl;
+    }
+    cout<<"Streamed "<<num_rams<<" logical rams of "<<num_circuits<<" circuits from "
+        <<(logic_rams_file == "-" ? "stdin" : logic_rams_file)<<endl;
+    return true;
+}
@@ -0,0 +1,16 @@
+#ifndef LAB3_IMPLEMENTATION_STREAM_H
+#define LAB3_IMPLEMENTATION_STREAM_H
+
+#include "circuit.h"
+
+//./mapping 1-4 -stream <logical ram file|->: reads the circuits one at a time, maps them a window of about
+//STREAM_WINDOW_RAMS rams at a time (with every option perform_core_mapper takes) and appends their lines to the
+//mapping file right away, so memory grows with the largest circuit instead of the whole benchmark set.
+//with verify_mapping every circuit is checked before it is written. false when a line of the input is wrong,
+//a mapping is illegal or the mapping file cannot be written (the reason is printed)
+const size_t STREAM_WINDOW_RAMS = 1 << 16;
+
+bool map_stream(const string& logic_rams_file, const string& logic_bc_file, const vector<resource>& resource_list,
+        const area_model& model, const mapper_options& options, const string& mapping_outname, bool verify_mapping);
+
+#endif //LAB3_IMPLEMENTATION_STREAM_H
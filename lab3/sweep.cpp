@@ -0,0 +1,438 @@
+#include "sweep.h"
+#include "report.h"
+#include "verify.h"
+#include "incremental.h"
+#include "checkpoint.h"
+#include <iomanip>
+#include <map>
+#include <unistd.h>
+#include <sys/wait.h>
+
+string arch_point::get_columns(){
+    string columns;
+    if(op == MB_WITH_LUTRAM){
+        columns = to_string(lutram_ratio) + " ";
+    }
+    for(size_t i = 0; i < bram_size.size(); i++){
+        columns += to_string(bram_size[i]) + " " + to_string(bram_mwidth[i]) + " " + to_string(bram_ratio[i]) + " ";
+    }
+    return columns;
+}
+
+//accepts a comma separated list where every item is a single value, a range <start>:<end> (step 1),
+//<start>:<end>:<step> (additive step) or <start>:<end>:x<factor> (multiplicative step, e.g. 1024:65536:x2)
+bool parse_sweep_list(string spec, vector<unsigned int>& values){
+    stringstream spec_stream(spec);
+    string item;
+    while(getline(spec_stream, item, ',')){
+        vector<string> fields;
+        stringstream item_stream(item);
+        string field;
+        while(getline(item_stream, field, ':')){
+            fields.push_back(field);
+        }
+        if(fields.empty() || fields.size() > 3){
+            return false;
+        }
+        bool multiply = false;
+        if(fields.size() == 3 && !fields[2].empty() && fields[2][0] == 'x'){
+            multiply = true;
+            fields[2] = fields[2].substr(1);
+        }
+        vector<unsigned long> numbers;
+        for(auto& number: fields){
+            if(number.empty() || number.find_first_not_of("0123456789") != string::npos){
+                return false;
+            }
+            numbers.push_back(stoul(number));
+        }
+        if(numbers.size() == 1){
+            values.push_back(numbers[0]);
+            continue;
+        }
+        unsigned long step = numbers.size() == 3 ? numbers[2] : 1;
+        if(numbers[0] == 0 || numbers[0] > numbers[1] || step == 0 || (multiply && step == 1)){
+            return false;
+        }
+        for(unsigned long value = numbers[0]; value <= numbers[1]; value = multiply ? value * step : value + step){
+            values.push_back(value);
+            if((multiply && value > numbers[1] / step) || (!multiply && value > numbers[1] - step)){
+                break;
+            }
+        }
+    }
+    return !values.empty();
+}
+
+//expand the parameter lists of a sweep into the cartesian product of architecture points
+static void expand_points(operationType op, unsigned int lutram_ratio, vector<vector<unsigned int> >& param_lists,
+                          size_t level, vector<unsigned int>& chosen, vector<arch_point>& point_list){
+    if(level == param_lists.size()){
+        vector<unsigned int> size_vec, mwidth_vec, bratio_vec;
+        for(size_t i = 0; i + 2 < chosen.size(); i += 3){
+            size_vec.push_back(chosen[i]);
+            mwidth_vec.push_back(chosen[i + 1]);
+            bratio_vec.push_back(chosen[i + 2]);
+        }
+        point_list.push_back(arch_point(op, size_vec, mwidth_vec, bratio_vec, lutram_ratio));
+        return;
+    }
+    for(auto value: param_lists[level]){
+        chosen.push_back(value);
+        expand_points(op, lutram_ratio, param_lists, level + 1, chosen, point_list);
+        chosen.pop_back();
+    }
+}
+
+bool parse_shard(const string& spec, unsigned int& shard_index, unsigned int& shard_count){
+    size_t slash = spec.find('/');
+    if(slash == string::npos){
+        return false;
+    }
+    string index_text = spec.substr(0, slash);
+    string count_text = spec.substr(slash + 1);
+    for(auto& number: {index_text, count_text}){
+        if(number.empty() || number.size() > 6 || number.find_first_not_of("0123456789") != string::npos){
+            return false;
+        }
+    }
+    //numbered from 1 on the command line
+    unsigned int index = stoul(index_text);
+    shard_count = stoul(count_text);
+    if(index == 0 || index > shard_count){
+        return false;
+    }
+    shard_index = index - 1;
+    return true;
+}
+
+int run_sweep(int argc, char **argv, vector<circuit>& logic_circuit_list, unsigned int num_threads, run_report* report,
+        const sweep_options& sweep_opts){
+    if(argc < 3){
+        cout<<"You need to pass the structure to sweep (2, 3 or 4) and its parameter lists"<<endl;
+        cout<<"Please refer to readme for details"<<endl;
+        return 0;
+    }
+    int sweep_arg = atoi(argv[2]);
+    operationType op;
+    string sweep_outname;
+    int list_count;
+    if(sweep_arg == 2){
+        op = NO_LUTRAM;
+        sweep_outname = "sweep_NOLUTRAM.txt";
+        list_count = 3;
+    }else if(sweep_arg == 3){
+        op = WITH_LUTRAM;
+        sweep_outname = "sweep_WITHLUTRAM.txt";
+        list_count = 3;
+    }else if(sweep_arg == 4){
+        op = MB_WITH_LUTRAM;
+        sweep_outname = "sweep_MBWITHLUTRAM.txt";
+        //the lutram ratio list followed by one (size, width, ratio) group of lists per BRAM type
+        list_count = 1 + 3 * ((argc - 4) / 3);
+        if(list_count < 7){
+            list_count = 7;
+        }
+    }else{
+        cout<<"Only structure 2, 3 or 4 can be swept"<<endl;
+        cout<<"Please refer to readme for details"<<endl;
+        return 0;
+    }
+    if(argc < 3 + list_count){
+        cout<<"You need to pass "<<list_count<<" parameter lists for structure "<<sweep_arg<<endl;
+        cout<<"Please refer to readme for details"<<endl;
+        return 0;
+    }
+
+    vector<vector<unsigned int> > param_lists(list_count);
+    for(int i = 0; i < list_count; i++){
+        if(!parse_sweep_list(argv[3 + i], param_lists[i])){
+            cout<<"Cannot analyze the parameter list: "<<argv[3 + i]<<endl;
+            cout<<"Please refer to readme for details"<<endl;
+            return 0;
+        }
+    }
+    //the lutram ratio of structure 4 is the first list, the remaining lists come in (size, width, ratio) groups
+    vector<unsigned int> lutram_ratio_list(1, 0);
+    if(op == MB_WITH_LUTRAM){
+        lutram_ratio_list = param_lists[0];
+        param_lists.erase(param_lists.begin());
+    }
+    vector<arch_point> point_list;
+    for(auto lutram_ratio: lutram_ratio_list){
+        vector<unsigned int> chosen;
+        expand_points(op, lutram_ratio, param_lists, 0, chosen, point_list);
+    }
+    for(auto& point: point_list){
+        input_parameter input_pack = point.get_input_pack();
+        for(size_t i = 0; i < input_pack.get_input_bram_size().size(); i++){
+            if(input_pack.get_input_bram_ratio()[i] == 0 || input_pack.get_input_bram_mwidth()[i] == 0 ||
+               input_pack.get_input_bram_size()[i] < input_pack.get_input_bram_mwidth()[i]){
+                cout<<"Invalid architecture point: "<<point.get_columns()<<endl;
+                cout<<"Ratios and widths should be positive and no BRAM can be narrower than one bit deep"<<endl;
+                return 0;
+            }
+        }
+        if(op == MB_WITH_LUTRAM && input_pack.get_input_lutram_ratio() == 0){
+            cout<<"Invalid architecture point: "<<point.get_columns()<<endl;
+            cout<<"The lutram support ratio should be positive"<<endl;
+            return 0;
+        }
+    }
+    cout<<"Sweeping "<<point_list.size()<<" architecture points over "<<logic_circuit_list.size()<<" circuits"<<endl;
+
+    //the resource lists are built once per point and shared read-only by every job of that point
+    phase_clock phases(report);
+    vector<vector<resource> > point_resource_list(point_list.size());
+    vector<area_model> point_model_list(point_list.size());
+    for(size_t p = 0; p < point_list.size(); p++){
+        construct_resource(point_resource_list[p], point_model_list[p], op, point_list[p].get_input_pack());
+        if(report != NULL){
+            string columns = point_list[p].get_columns();
+            report->add_point(columns.substr(0, columns.size() - 1), point_resource_list[p], logic_circuit_list.size());
+        }
+    }
+    phases.mark("resources");
+    //points that only differ in ratios share the same BRAM geometry, and so the same candidate cache
+    vector<candidate_cache> cache_list;
+    vector<size_t> point_cache_index(point_list.size());
+    map<string, size_t> geometry_cache_index;
+    for(size_t p = 0; p < point_list.size(); p++){
+        string geometry = resource_geometry_key(point_resource_list[p]);
+        if(!geometry_cache_index.count(geometry)){
+            geometry_cache_index[geometry] = cache_list.size();
+            cache_list.push_back(candidate_cache());
+            cache_list.back().add_circuits(point_resource_list[p], logic_circuit_list);
+        }
+        point_cache_index[p] = geometry_cache_index[geometry];
+    }
+    phases.mark("candidate_cache");
+
+    //one job per (point, circuit) pair, the biggest circuits of every point are handed out first; incremental and
+    //checkpointed sweeps take the areas of pairs they have seen before instead
+    size_t num_circuits = logic_circuit_list.size();
+    size_t num_jobs = point_list.size() * num_circuits;
+    vector<vector<double> > area_table(point_list.size(), vector<double>(num_circuits, 0.0));
+    string sweep_stem = sweep_outname.substr(0, sweep_outname.size() - 4);
+    string state_outname = sweep_stem + ".state";
+    string checkpoint_outname = sweep_stem + ".checkpoint";
+    bool keyed = sweep_opts.incremental || sweep_opts.checkpoint;
+    vector<uint64_t> job_key;
+    unordered_map<uint64_t, double> stored_area;
+    if(keyed){
+        if(sweep_opts.incremental){
+            load_area_state(state_outname, stored_area);
+        }
+        if(sweep_opts.checkpoint){
+            size_t damaged_bytes;
+            size_t num_records = load_area_checkpoint(checkpoint_outname, stored_area, damaged_bytes);
+            cout<<"Checkpoint "<<checkpoint_outname<<" holds "<<num_records<<" records";
+            if(damaged_bytes > 0){
+                cout<<", "<<damaged_bytes<<" damaged bytes were skipped";
+            }
+            cout<<endl;
+        }
+        vector<uint64_t> circuit_key(num_circuits);
+        for(size_t c = 0; c < num_circuits; c++){
+            circuit_key[c] = circuit_fingerprint(logic_circuit_list[c]);
+        }
+        job_key.resize(num_jobs);
+        for(size_t p = 0; p < point_list.size(); p++){
+            uint64_t point_key = architecture_fingerprint(point_resource_list[p], point_model_list[p], mapper_options());
+            for(size_t c = 0; c < num_circuits; c++){
+                job_key[p * num_circuits + c] = job_fingerprint(point_key, circuit_key[c]);
+            }
+        }
+    }
+    //pairs are numbered in that order whether they are kept or not, and shard k of n takes every n-th one from k,
+    //so separate or restarted runs of the same sweep always agree on the pairs of every shard
+    vector<char> job_done(num_jobs, 0);
+    vector<vector<size_t> > shard_jobs(sweep_opts.shard_count);
+    size_t position = 0;
+    vector<size_t> circuit_order = largest_circuit_first(logic_circuit_list);
+    for(auto c: circuit_order){
+        for(size_t p = 0; p < point_list.size(); p++, position++){
+            size_t job = p * num_circuits + c;
+            auto stored = keyed ? stored_area.find(job_key[job]) : stored_area.end();
+            if(stored != stored_area.end()){
+                area_table[p][c] = stored->second;
+                job_done[job] = 1;
+            }else{
+                shard_jobs[position % sweep_opts.shard_count].push_back(job);
+            }
+        }
+    }
+    size_t num_to_map = shard_jobs[sweep_opts.shard_index].size();
+    if(sweep_opts.fork_shards){
+        num_to_map = num_jobs - count(job_done.begin(), job_done.end(), 1);
+    }
+    if(keyed){
+        cout<<"Mapping "<<num_to_map<<" of "<<num_jobs<<" (point, circuit) pairs, the others are kept from "
+            <<(sweep_opts.incremental ? state_outname : checkpoint_outname);
+        if(sweep_opts.incremental && sweep_opts.checkpoint){
+            cout<<" and "<<checkpoint_outname;
+        }
+        if(sweep_opts.shard_count > 1 && !sweep_opts.fork_shards){
+            cout<<" or left to the other shards";
+        }
+        cout<<endl;
+    }
+    area_checkpoint checkpoint;
+    if(sweep_opts.checkpoint && !checkpoint.open_file(checkpoint_outname)){
+        cout<<"Cannot open the sweep checkpoint "<<checkpoint_outname<<endl;
+        return 1;
+    }
+    //every mapping is checked and priced in memory, the table holds the checker's areas; only checked pairs go to
+    //the checkpoint
+    vector<string> job_error(num_jobs);
+    atomic<bool> checkpoint_failed(false);
+    auto map_job = [&](size_t job){
+        size_t p = job / num_circuits;
+        size_t c = job % num_circuits;
+        //rows of the worker's own arena, which grows to the largest circuit once and is reused by every later job
+        static thread_local mapping_arena scratch;
+        size_t num_rams = logic_circuit_list[c].get_ram_list().size();
+        scratch.reserve_rows(num_rams);
+        mapping_result result;
+        scratch.bind(result, 0, num_rams);
+        map_circuit(logic_circuit_list[c], point_resource_list[p], point_model_list[p], cache_list[point_cache_index[p]], result);
+        if(!logic_circuit_list[c].get_ram_list().empty()){
+            verify_circuit_mapping(logic_circuit_list[c], result.mapped_list, point_resource_list[p], point_model_list[p],
+                                   area_table[p][c], job_error[job]);
+        }
+        if(report != NULL){
+            circuit_report& circuit_figures = report->get_point(p).circuit_list[c];
+            fill_circuit_report(logic_circuit_list[c], point_model_list[p], cache_list[point_cache_index[p]],
+                                result.choice_list, 1, result.skipped_by_bound, circuit_figures);
+            //a sweep has no exact search or refinement, its greedy mapping is the final one
+            circuit_figures.greedy_area = circuit_figures.area;
+        }
+        if(job_error[job].empty()){
+            job_done[job] = 1;
+            if(sweep_opts.checkpoint && !checkpoint.append(job_key[job], area_table[p][c])){
+                checkpoint_failed = true;
+            }
+        }
+    };
+    auto mapping_failed = [&](){
+        if(checkpoint_failed){
+            cout<<"Cannot append to the sweep checkpoint "<<checkpoint_outname<<", a restart maps those pairs again"<<endl;
+        }
+        for(size_t job = 0; job < job_error.size(); job++){
+            if(!job_error[job].empty()){
+                cout<<"Illegal mapping at point "<<point_list[job / num_circuits].get_columns()<<"- "<<job_error[job]<<endl;
+                cout<<"Something went wrong"<<endl;
+                return true;
+            }
+        }
+        return false;
+    };
+    if(sweep_opts.fork_shards){
+        //every shard maps in a child process with its share of the threads; the children inherit the circuits, the
+        //resource lists and the candidate caches, and hand their areas back through the checkpoint
+        unsigned int shard_threads = max(1u, num_threads / sweep_opts.shard_count);
+        vector<pid_t> child_list;
+        cout.flush();
+        for(unsigned int k = 0; k < sweep_opts.shard_count; k++){
+            pid_t child = fork();
+            if(child == 0){
+                run_parallel_jobs(shard_jobs[k], shard_threads, map_job);
+                int status = mapping_failed() || !checkpoint.close_file() ? 1 : 0;
+                cout.flush();
+                _exit(status);
+            }
+            if(child < 0){
+                cout<<"Cannot start the process of shard "<<k + 1<<" of "<<sweep_opts.shard_count<<endl;
+                break;
+            }
+            child_list.push_back(child);
+        }
+        bool shard_failed = child_list.size() < sweep_opts.shard_count;
+        for(size_t k = 0; k < child_list.size(); k++){
+            int status;
+            if(waitpid(child_list[k], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0){
+                cout<<"Shard "<<k + 1<<" of "<<sweep_opts.shard_count<<" did not finish, its checkpointed pairs are kept"<<endl;
+                shard_failed = true;
+            }
+        }
+        if(shard_failed){
+            return 1;
+        }
+    }else{
+        run_parallel_jobs(shard_jobs[sweep_opts.shard_index], num_threads, map_job);
+        if(mapping_failed()){
+            return 1;
+        }
+    }
+    phases.mark("mapping");
+    if(sweep_opts.checkpoint){
+        if(!checkpoint.close_file()){
+            cout<<"Cannot sync the sweep checkpoint "<<checkpoint_outname<<endl;
+        }
+        //other shards have been appending meanwhile, whatever they finished completes the table
+        if(sweep_opts.shard_count > 1){
+            unordered_map<uint64_t, double> checkpoint_area;
+            size_t damaged_bytes;
+            load_area_checkpoint(checkpoint_outname, checkpoint_area, damaged_bytes);
+            for(size_t job = 0; job < num_jobs; job++){
+                auto stored = job_done[job] ? checkpoint_area.end() : checkpoint_area.find(job_key[job]);
+                if(stored != checkpoint_area.end()){
+                    area_table[job / num_circuits][job % num_circuits] = stored->second;
+                    job_done[job] = 1;
+                }
+            }
+        }
+        size_t num_done = count(job_done.begin(), job_done.end(), 1);
+        if(num_done < num_jobs){
+            cout<<num_done<<" of "<<num_jobs<<" (point, circuit) pairs are in "<<checkpoint_outname
+                <<", the summary is written by the run that finds all of them there"<<endl;
+            return 0;
+        }
+        phases.mark("merge");
+    }
+
+    //written under a temporary name and renamed, shards finishing together may both write the same summary
+    string temp_outname = sweep_outname + ".tmp" + to_string(getpid());
+    ofstream outs;
+    outs.open(temp_outname);
+    if(op == MB_WITH_LUTRAM){
+        outs<<"lutram_ratio ";
+    }
+    for(size_t i = 0; i < param_lists.size() / 3; i++){
+        outs<<"bram"<<i + 1<<"_size bram"<<i + 1<<"_width bram"<<i + 1<<"_ratio ";
+    }
+    outs<<"geomean_area";
+    for(auto& circuit: logic_circuit_list){
+        outs<<" circuit_"<<circuit.get_circuit_id();
+    }
+    outs<<"\n";
+    outs<<fixed<<setprecision(2);
+    for(size_t p = 0; p < point_list.size(); p++){
+        double geomean = geometric_mean_area(logic_circuit_list, area_table[p]);
+        outs<<point_list[p].get_columns()<<geomean;
+        for(auto area: area_table[p]){
+            outs<<" "<<area;
+        }
+        outs<<"\n";
+        cout<<"point: "<<point_list[p].get_columns()<<"geometric mean area is: "<<geomean<<endl;
+    }
+    outs.close();
+    if(outs.fail() || rename(temp_outname.c_str(), sweep_outname.c_str()) != 0){
+        unlink(temp_outname.c_str());
+        cout<<"Cannot write the sweep summary "<<sweep_outname<<endl;
+        return 1;
+    }
+    if(sweep_opts.incremental){
+        //only the pairs of this sweep are kept, so the state never grows past the last sweep
+        unordered_map<uint64_t, double> area_by_job;
+        for(size_t job = 0; job < job_key.size(); job++){
+            area_by_job[job_key[job]] = area_table[job / num_circuits][job % num_circuits];
+        }
+        if(!write_area_state(state_outname, area_by_job)){
+            cout<<"Cannot write the sweep state "<<state_outname<<", the next sweep will map every pair"<<endl;
+        }
+    }
+    phases.mark("output");
+    cout<<"Sweep summary written to "<<sweep_outname<<endl;
+    return 0;
+}
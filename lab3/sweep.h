@@ -0,0 +1,50 @@
+#ifndef LAB3_IMPLEMENTATION_SWEEP_H
+#define LAB3_IMPLEMENTATION_SWEEP_H
+
+#include "circuit.h"
+
+//one architecture of a design-space sweep, described the same way as a single ./mapping 2|3|4 run
+class arch_point {
+private:
+    operationType op;
+    vector<unsigned int> bram_size;
+    vector<unsigned int> bram_mwidth;
+    vector<unsigned int> bram_ratio;
+    unsigned int lutram_ratio;
+public:
+    arch_point(operationType i_op, vector<unsigned int> i_size, vector<unsigned int> i_mwidth,
+            vector<unsigned int> i_bratio, unsigned int i_lratio){
+        op = i_op;
+        bram_size = i_size;
+        bram_mwidth = i_mwidth;
+        bram_ratio = i_bratio;
+        lutram_ratio = i_lratio;
+    }
+    operationType get_op() { return op; }
+    input_parameter get_input_pack(){
+        return input_parameter(bram_size, bram_mwidth, bram_ratio, lutram_ratio);
+    }
+    string get_columns();
+};
+
+bool parse_sweep_list(string spec, vector<unsigned int>& values);
+
+//how the (point, circuit) pairs of a sweep are split up and which earlier results it may take
+struct sweep_options {
+    bool incremental = false; //take the pairs in the state file of the previous sweep
+    bool checkpoint = false; //append every checked pair to the checkpoint file, take the pairs already in it
+    unsigned int shard_index = 0; //this run maps the pairs of shard shard_index of shard_count
+    unsigned int shard_count = 1;
+    bool fork_shards = false; //map every shard in a local process of its own instead
+};
+
+//parses "<index>/<count>" of -shard, with index below count
+bool parse_shard(const string& spec, unsigned int& shard_index, unsigned int& shard_count);
+
+//report, when not NULL, gets the phase times and one point per architecture point. incremental sweeps only map
+//the (point, circuit) pairs whose area is not in the state file next to the summary, checkpointed sweeps the
+//pairs not in the checkpoint; the summary is written by the run that finds every pair mapped
+int run_sweep(int argc, char **argv, vector<circuit>& logic_circuit_list, unsigned int num_threads, run_report* report,
+        const sweep_options& sweep_opts);
+
+#endif //LAB3_IMPLEMENTATION_SWEEP_H
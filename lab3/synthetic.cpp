@@ -0,0 +1,52 @@
+#include "synthetic.h"
+#include "output_writer.h"
+
+static unsigned int log_uniform(mt19937_64& generator, unsigned int low, unsigned int high){
+    uniform_real_distribution<double> exponent(log((double)low), log((double)high + 1));
+    unsigned int value = (unsigned int)exp(exponent(generator));
+    return value < low ? low : (value > high ? high : value);
+}
+
+long long write_synthetic_benchmark(const synthetic_spec& spec, const string& logic_rams_file,
+        const string& logic_bc_file){
+    static const ramMode mode_list[] = {SinglePort, SimpleDualPort, TrueDualPort, ROM};
+    mt19937_64 generator(spec.seed);
+    uniform_int_distribution<unsigned int> ram_count(spec.min_rams, spec.max_rams);
+    uniform_int_distribution<unsigned int> lb_count(spec.min_lb, spec.max_lb);
+    discrete_distribution<int> mode_pick(spec.mode_weight, spec.mode_weight + 4);
+
+    output_buffer bc_outs;
+    output_buffer rams_outs;
+    if(!bc_outs.open_file(logic_bc_file) || !rams_outs.open_file(logic_rams_file)){
+        return -1;
+    }
+    bc_outs.append_text("Circuit\t# Logic blocks (N=10, k=6, fracturable)\n");
+    rams_outs.append_text("Num_Circuits ");
+    rams_outs.append_uint(spec.num_circuits);
+    rams_outs.append_text("\nCircuit\tRamID\tMode\t\tDepth\tWidth\n");
+    long long total_rams = 0;
+    for(unsigned int c = 0; c < spec.num_circuits; c++){
+        bc_outs.append_uint(c);
+        bc_outs.append_text("\t");
+        bc_outs.append_uint(lb_count(generator));
+        bc_outs.append_text("\n");
+        unsigned int num_rams = ram_count(generator);
+        for(unsigned int r = 0; r < num_rams; r++){
+            rams_outs.append_uint(c);
+            rams_outs.append_text("\t");
+            rams_outs.append_uint(r);
+            rams_outs.append_text("\t");
+            rams_outs.append_text(ram_mode_name(mode_list[mode_pick(generator)]));
+            rams_outs.append_text("\t");
+            rams_outs.append_uint(log_uniform(generator, spec.min_depth, spec.max_depth));
+            rams_outs.append_text("\t");
+            rams_outs.append_uint(log_uniform(generator, spec.min_width, spec.max_width));
+            rams_outs.append_text("\n");
+        }
+        total_rams += num_rams;
+    }
+    if(!bc_outs.close_file() || !rams_outs.close_file()){
+        return -1;
+    }
+    return total_rams;
+}
@@ -0,0 +1,27 @@
+#ifndef LAB3_IMPLEMENTATION_SYNTHETIC_H
+#define LAB3_IMPLEMENTATION_SYNTHETIC_H
+
+#include "circuit.h"
+
+//shape of a generated benchmark set; every random draw comes from one generator seeded with seed, so the same
+//spec always writes the same two files
+struct synthetic_spec {
+    unsigned int num_circuits = 69;
+    unsigned int min_rams = 1; //rams per circuit, uniform in [min_rams, max_rams]
+    unsigned int max_rams = 400;
+    double mode_weight[4] = {1, 1, 1, 1}; //relative share of SinglePort, SimpleDualPort, TrueDualPort, ROM
+    unsigned int min_depth = 16; //depth and width are log-uniform in their ranges
+    unsigned int max_depth = 65536;
+    unsigned int min_width = 1;
+    unsigned int max_width = 128;
+    unsigned int min_lb = 300; //logic blocks per circuit, uniform in [min_lb, max_lb]
+    unsigned int max_lb = 40000;
+    unsigned int seed = 1;
+};
+
+//writes logical_rams.txt / logic_block_count.txt style files for the spec, returns the number of rams written
+//or -1 when a file cannot be written
+long long write_synthetic_benchmark(const synthetic_spec& spec, const string& logic_rams_file,
+        const string& logic_bc_file);
+
+#endif //LAB3_IMPLEMENTATION_SYNTHETIC_H
@@ -0,0 +1,99 @@
+#include "verify.h"
+#include <unordered_set>
+
+static bool reject(string& error, const circuit& circuit, const mappedRam& mapped, const string& reason){
+    ostringstream message;
+    message<<"circuit "<<circuit.get_circuit_id()<<" ram "<<mapped.get_ram_id()<<": "<<reason;
+    error = message.str();
+    return false;
+}
+
+bool verify_circuit_mapping(const circuit& circuit, const_span<mappedRam> mapped_list,
+        const vector<resource>& resource_list, const area_model& model, double& area, string& error){
+    const_span<logicRam> logic_ram_list = circuit.get_ram_list();
+    if(mapped_list.size() != logic_ram_list.size()){
+        error = "circuit " + to_string(circuit.get_circuit_id()) + ": " + to_string(mapped_list.size()) +
+                " mapped rams for " + to_string(logic_ram_list.size()) + " logical rams";
+        return false;
+    }
+    unordered_map<unsigned int, const logicRam*> logic_ram_by_id;
+    for(auto& logicram: logic_ram_list){
+        logic_ram_by_id[logicram.get_lram_id()] = &logicram;
+    }
+    unordered_set<unsigned int> mapped_ram_ids;
+    unordered_set<unsigned int> mapper_ids;
+    mapping_counters counters(model, circuit.get_circuit_num_lb());
+    for(auto& mapped: mapped_list){
+        auto found = logic_ram_by_id.find(mapped.get_ram_id());
+        if(found == logic_ram_by_id.end()){
+            return reject(error, circuit, mapped, "is not a logical ram of the circuit");
+        }
+        if(!mapped_ram_ids.insert(mapped.get_ram_id()).second){
+            return reject(error, circuit, mapped, "is mapped more than once");
+        }
+        if(!mapper_ids.insert(mapped.get_mapper_id()).second){
+            return reject(error, circuit, mapped, "reuses ID " + to_string(mapped.get_mapper_id()));
+        }
+        const logicRam& logicram = *found->second;
+        if(mapped.get_ldepth() != logicram.get_lram_depth() || mapped.get_lwidth() != logicram.get_lram_width() ||
+           mapped.get_lram_mode() != logicram.get_lram_mode()){
+            return reject(error, circuit, mapped, "does not keep the depth, width and mode of the logical ram");
+        }
+        size_t r = 0;
+        while(r < resource_list.size() && resource_list[r].get_output_type() != mapped.get_map_type()){
+            r++;
+        }
+        if(r == resource_list.size()){
+            return reject(error, circuit, mapped, "uses Type " + to_string(mapped.get_map_type()) +
+                                                  ", which the architecture does not have");
+        }
+        const resource& physical_ram = resource_list[r];
+        bool legal_configuration = false;
+        for(auto& dw_pair: physical_ram.get_comb_list()){
+            if(dw_pair.first == mapped.get_pdepth() && dw_pair.second == mapped.get_pwidth()){
+                legal_configuration = true;
+            }
+        }
+        if(!legal_configuration){
+            return reject(error, circuit, mapped, to_string(mapped.get_pdepth()) + "x" + to_string(mapped.get_pwidth()) +
+                                                  " is not a configuration of Type " + to_string(mapped.get_map_type()));
+        }
+        bool is_tdp = mapped.get_lram_mode() == TrueDualPort;
+        if(is_tdp && mapped.get_pwidth() > physical_ram.get_tdp_max_width()){
+            return reject(error, circuit, mapped, "width " + to_string(mapped.get_pwidth()) +
+                                                  " cannot be used in TrueDualPort mode");
+        }
+        if(mapped.get_s() < 1 || mapped.get_s() > 16 || mapped.get_p() < 1){
+            return reject(error, circuit, mapped, "S must be 1 to 16 and P at least 1");
+        }
+        if((uint64_t)mapped.get_s() * mapped.get_pdepth() < mapped.get_ldepth() ||
+           (uint64_t)mapped.get_p() * mapped.get_pwidth() < mapped.get_lwidth()){
+            return reject(error, circuit, mapped, "S x P blocks do not cover LD x LW");
+        }
+        unsigned int needed_luts = serial_extra_luts(mapped.get_s(), mapped.get_lwidth(), is_tdp);
+        if(mapped.get_lut() < needed_luts){
+            return reject(error, circuit, mapped, to_string(mapped.get_lut()) + " additional luts, " +
+                                                  to_string(needed_luts) + " are needed");
+        }
+        map_candidate priced;
+        priced.resource_index = r;
+        priced.serial = mapped.get_s();
+        priced.parallel = mapped.get_p();
+        priced.extra_LB = (mapped.get_lut() + 9) / 10;
+        counters.add(priced);
+    }
+    area = counters.area();
+    return true;
+}
+
+double geometric_mean_area(const vector<circuit>& logic_circuit_list, const vector<double>& area_list){
+    double log_sum = 0.0;
+    unsigned int counted = 0;
+    for(size_t i = 0; i < logic_circuit_list.size(); i++){
+        if(!logic_circuit_list[i].get_ram_list().empty() && area_list[i] > 0){
+            log_sum += log(area_list[i]);
+            counted++;
+        }
+    }
+    return counted == 0 ? 0.0 : exp(log_sum / counted);
+}
@@ -0,0 +1,18 @@
+#ifndef LAB3_IMPLEMENTATION_VERIFY_H
+#define LAB3_IMPLEMENTATION_VERIFY_H
+
+#include "refine.h"
+
+//in-process version of the checker for the mapping of one circuit, run on the mapped rams in memory instead of
+//a written mapping file. every logical ram must be mapped exactly once under a unique ID, with its own depth,
+//width and mode, on a legal depth/width configuration of a resource of the architecture (TrueDualPort only up to
+//its TDP width), with at most 16 blocks in series, enough blocks to hold LD x LW and at least the LUTs the
+//serial blocks need. on success area is the circuit area priced like the checker (see mapping_counters),
+//otherwise error says which ram is wrong and why
+bool verify_circuit_mapping(const circuit& circuit, const_span<mappedRam> mapped_list,
+        const vector<resource>& resource_list, const area_model& model, double& area, string& error);
+
+//geometric mean over the circuits that have logical rams; circuits without any are never mapped
+double geometric_mean_area(const vector<circuit>& logic_circuit_list, const vector<double>& area_list);
+
+#endif //LAB3_IMPLEMENTATION_VERIFY_H